@@ -0,0 +1,558 @@
+#include "Bench.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Arena.h"
+#include "Leaderboard.h"
+#include "OccupancyGrid.h"
+#include "Platform.h"
+#include "SpatialHash.h"
+#include "World.h"
+
+/**
+* Microseconds since start.
+*/
+static double microsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+* The number of collidables in each run, from 10 to 100k.
+*/
+static const int benchSizes[] = { 10, 100, 1000, 10000, 100000 };
+
+/**
+* Fill a square world with count segment-sized platforms, about a quarter of the cells full, like a busy board.
+*/
+static void makeCollidables(int count, std::mt19937* random, std::vector<std::unique_ptr<Platform>>* objects, float* worldSize) {
+    int side = (int)std::ceil(std::sqrt(count * 4.0));
+    *worldSize = side * HASH_CELL_SIZE;
+    std::uniform_int_distribution<int> cell(0, side - 1);
+    for (int i = 0; i < count; i++) {
+        Platform* platform = new Platform;
+        platform->setSize(sf::Vector2f(HASH_CELL_SIZE, HASH_CELL_SIZE));
+        platform->setPosition(cell(*random) * HASH_CELL_SIZE, cell(*random) * HASH_CELL_SIZE);
+        objects->push_back(std::unique_ptr<Platform>(platform));
+    }
+}
+
+/**
+* Random segment-sized boxes to query with.
+*/
+static void makeQueries(int count, float worldSize, std::mt19937* random, std::vector<sf::FloatRect>* queries) {
+    std::uniform_real_distribution<float> position(0, worldSize);
+    for (int i = 0; i < count; i++) {
+        queries->push_back(sf::FloatRect(position(*random), position(*random), HASH_CELL_SIZE, HASH_CELL_SIZE));
+    }
+}
+
+/**
+* Time queries against the hash with one kernel. Returns ns per query and sets hits.
+*/
+static double timeQueries(SpatialHash* hash, std::vector<sf::FloatRect>& queries, SpatialHash::KERNEL kernel, std::vector<GameObject*>* results) {
+    SpatialHash::useKernel(kernel);
+    results->assign(queries.size(), nullptr);
+    GameObject* found;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < queries.size(); q++) {
+        if (hash->query(queries[q], &found)) {
+            (*results)[q] = found;
+        }
+    }
+    double ns = microsSince(start) * 1000.0 / queries.size();
+    SpatialHash::useKernel(SpatialHash::AUTO);
+    return ns;
+}
+
+/**
+* Run the same queries through the scalar kernel and the best SIMD kernel. Fails if they disagree.
+*/
+static int compareKernels(int count, SpatialHash* hash, std::vector<sf::FloatRect>& queries, double linearNs, double buildMicros) {
+    std::vector<GameObject*> scalarResults;
+    std::vector<GameObject*> simdResults;
+    double scalarNs = timeQueries(hash, queries, SpatialHash::SCALAR, &scalarResults);
+    double simdNs = timeQueries(hash, queries, SpatialHash::AUTO, &simdResults);
+    int hits = 0;
+    for (GameObject* result : simdResults) {
+        hits += result != nullptr;
+    }
+    char line[160];
+    snprintf(line, sizeof(line), "%11d  %12.1f  %12.1f  %10.1f  %13.0f  %d/%d", count, linearNs, scalarNs, simdNs, buildMicros, hits, (int)queries.size());
+    std::cout << line << std::endl;
+    if (scalarResults != simdResults) {
+        std::cout << SpatialHash::kernelName() << " kernel disagrees with the scalar kernel" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int benchCollisions(float cellSize) {
+    std::mt19937 random(481);
+    std::cout << "kernel: " << SpatialHash::kernelName() << ", cell size " << cellSize << std::endl;
+    std::cout << "collidables  linear ns/q  scalar ns/q  simd ns/q  hash build us  hits" << std::endl;
+    for (int count : benchSizes) {
+        std::vector<std::unique_ptr<Platform>> objects;
+        float worldSize;
+        makeCollidables(count, &random, &objects, &worldSize);
+        std::list<GameObject*> collidables;
+        for (std::unique_ptr<Platform>& object : objects) {
+            collidables.push_back(object.get());
+        }
+
+        //The linear scan gets fewer queries so the big sizes finish.
+        std::vector<sf::FloatRect> queries;
+        //One big cell means every query walks every object, so ask fewer.
+        makeQueries(cellSize > HASH_CELL_SIZE ? 2000 : 100000, worldSize, &random, &queries);
+        int linearQueries = std::max(100, std::min((int)queries.size(), 10000000 / count));
+
+        //What checkCollisions used to do.
+        std::vector<GameObject*> linearResults(linearQueries, nullptr);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int q = 0; q < linearQueries; q++) {
+            for (GameObject* i : collidables) {
+                if (queries[q].intersects((dynamic_cast<sf::Shape*>(i))->getGlobalBounds())) {
+                    linearResults[q] = i;
+                    break;
+                }
+            }
+        }
+        double linearNs = microsSince(start) * 1000.0 / linearQueries;
+
+        SpatialHash hash(cellSize);
+        start = std::chrono::steady_clock::now();
+        for (GameObject* i : collidables) {
+            hash.insert(i, dynamic_cast<sf::Shape*>(i)->getGlobalBounds());
+        }
+        double buildMicros = microsSince(start);
+
+        //The hash must find exactly what the scan found.
+        GameObject* found;
+        for (int q = 0; q < linearQueries; q++) {
+            GameObject* result = hash.query(queries[q], &found) ? found : nullptr;
+            if (result != linearResults[q]) {
+                std::cout << "hash and linear scan disagree on query " << q << std::endl;
+                return 1;
+            }
+        }
+        if (compareKernels(count, &hash, queries, linearNs, buildMicros) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+* Stands in for RenderTarget::draw, which needs a display. Keeps the compiler from dropping the loop.
+*/
+static volatile uintptr_t drawSink;
+static void drawStandIn(const sf::Drawable& drawable) {
+    drawSink = drawSink + (uintptr_t)&drawable;
+}
+
+/**
+* Time finding each object's drawable over 10k objects, the old way (a dynamic_cast per object per frame) against
+* the registered interface pointers. Only the lookup is timed: every drawable goes to a stand-in, since the real
+* draw calls need a window, so this says nothing about what a frame costs.
+*/
+static int benchDispatch() {
+    const int count = 10000;
+    const int frames = 2000;
+    std::mt19937 random(481);
+    std::vector<std::unique_ptr<Platform>> objects;
+    float worldSize;
+    makeCollidables(count, &random, &objects, &worldSize);
+    std::list<GameObject*> oldDrawables;
+    std::vector<RegisteredObject> drawables;
+    for (std::unique_ptr<Platform>& object : objects) {
+        oldDrawables.push_back(object.get());
+        drawables.push_back(RegisteredObject(object.get()));
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        for (GameObject* i : oldDrawables) {
+            drawStandIn(*(dynamic_cast<sf::Drawable*>(i)));
+        }
+    }
+    double castMicros = microsSince(start) / frames;
+
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        for (RegisteredObject& i : drawables) {
+            drawStandIn(*i.drawable);
+        }
+    }
+    double registeredMicros = microsSince(start) / frames;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%d drawables: dynamic_cast %.1f us per pass, registered %.1f us per pass", count, castMicros, registeredMicros);
+    std::cout << line << std::endl;
+    return 0;
+}
+
+/**
+* Time the free-cell bookkeeping of one snake tic on the real 39x29 board as it fills up: the head takes a cell,
+* the tail gives one back and an apple is placed. The old way searches a list of free positions for the head and
+* walks it to a random index for the apple, the grid does the same with OccupancyGrid.
+*/
+static int benchGrid() {
+    const int columns = 39;
+    const int rows = 29;
+    const int tics = 20000;
+    const int fills[] = { 0, 25, 50, 75, 95 };
+    std::mt19937 random(481);
+    for (int fill : fills) {
+        //Take the same random cells in both, leaving fill percent of the board occupied.
+        OccupancyGrid grid(columns, rows, sf::Vector2f(10, 10), 20.f);
+        std::vector<int> cells(columns * rows);
+        for (int i = 0; i < columns * rows; i++) {
+            cells[i] = i;
+        }
+        std::shuffle(cells.begin(), cells.end(), random);
+        int taken = columns * rows * fill / 100;
+        std::list<sf::Vector2f> unoccupied;
+        for (int i = 0; i < columns * rows; i++) {
+            if (i < taken) {
+                grid.occupy(cells[i]);
+            }
+            else {
+                unoccupied.push_back(grid.positionOf(cells[i]));
+            }
+        }
+        //Each tic the head moves into a free cell and the tail leaves an occupied one, so the fill stays put.
+        std::vector<int> heads(tics);
+        std::vector<int> tails(tics);
+        std::vector<int> occupiedCells(cells.begin(), cells.begin() + taken);
+        std::vector<int> freeCells(cells.begin() + taken, cells.end());
+        for (int tic = 0; tic < tics; tic++) {
+            std::uniform_int_distribution<size_t> pickFree(0, freeCells.size() - 1);
+            size_t head = pickFree(random);
+            heads[tic] = freeCells[head];
+            if (occupiedCells.empty()) {
+                tails[tic] = heads[tic];
+                continue;
+            }
+            std::uniform_int_distribution<size_t> pickOccupied(0, occupiedCells.size() - 1);
+            size_t tail = pickOccupied(random);
+            tails[tic] = occupiedCells[tail];
+            std::swap(freeCells[head], occupiedCells[tail]);
+        }
+
+        int sink = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int tic = 0; tic < tics; tic++) {
+            sf::Vector2f head = grid.positionOf(heads[tic]);
+            for (std::list<sf::Vector2f>::iterator it = unoccupied.begin(); it != unoccupied.end(); it++) {
+                if (*it == head) {
+                    unoccupied.erase(it);
+                    break;
+                }
+            }
+            unoccupied.push_back(grid.positionOf(tails[tic]));
+            int appleIndex = rand() % unoccupied.size();
+            std::list<sf::Vector2f>::iterator apple = unoccupied.begin();
+            std::advance(apple, appleIndex);
+            sink += (int)apple->x;
+        }
+        double listNs = microsSince(start) * 1000 / tics;
+
+        start = std::chrono::steady_clock::now();
+        for (int tic = 0; tic < tics; tic++) {
+            grid.occupy(heads[tic]);
+            grid.release(tails[tic]);
+            sink += grid.randomFree();
+        }
+        double gridNs = microsSince(start) * 1000 / tics;
+
+        char line[160];
+        snprintf(line, sizeof(line), "%3d%% full: list %7.1f ns/tic, grid %5.1f ns/tic (%d)", fill, listNs, gridNs, sink & 1);
+        std::cout << line << std::endl;
+    }
+    return 0;
+}
+
+/**
+* Step a server arena with 500 snakes steered like the bots (a random turn about one tic in four) and time the
+* step and writing the published state. The server runs at 1000 / TIC tics a second on one thread, so the step
+* has to fit in a tic with room to spare for everything else.
+*/
+static int benchArena() {
+    const int snakes = 500;
+    const int size = 128;
+    const int tics = 2000;
+    Level level = Level::makeOpen(size, size);
+    Arena arena(&level, 481);
+    std::mt19937 random(481);
+    for (int i = 0; i < snakes; i++) {
+        arena.addSnake(i);
+    }
+    //Decide the inputs up front so only the arena is timed.
+    std::vector<int> turns(tics * snakes);
+    std::uniform_int_distribution<int> choice(0, 15);
+    for (int& turn : turns) {
+        turn = choice(random);
+    }
+
+    double stepMicros = 0;
+    double stateMicros = 0;
+    size_t stateBytes = 0;
+    //Grows to the biggest state once, like a pooled buffer would.
+    std::vector<char> state;
+    for (int tic = 0; tic < tics; tic++) {
+        for (int i = 0; i < snakes; i++) {
+            //Values past DOWN are no turn.
+            arena.steer(i, turns[tic * snakes + i]);
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        arena.step();
+        stepMicros += microsSince(start);
+        start = std::chrono::steady_clock::now();
+        bool full = tic % BOARD_FULL_TICS == 0;
+        state.resize(std::max(state.size(), arena.stateBound(full)));
+        stateBytes += arena.writeState(state.data(), full);
+        stateMicros += microsSince(start);
+    }
+    int deaths = 0;
+    for (ArenaSnake& snake : *arena.getSnakes()) {
+        deaths += snake.deaths;
+    }
+
+    double ticMicros = (stepMicros + stateMicros) / tics;
+    char line[256];
+    snprintf(line, sizeof(line), "%d snakes on %dx%d: step %.1f us/tic, state %.1f us/tic (%zu bytes), %.0f tics/s on one core (%d deaths, best %d)",
+        snakes, size, size, stepMicros / tics, stateMicros / tics, stateBytes / tics, 1000000.0 / ticMicros, deaths, arena.getBestScore());
+    std::cout << line << std::endl;
+    return ticMicros < 50000 ? 0 : 1;
+}
+
+/**
+* Step two arenas with the same seed and the same inputs, one on the calling thread alone and one with a worker for
+* every other core, and time them. 20k snakes spread over a 2048x2048 board keep every region about as busy. The
+* published states have to match every tic, or the regions depend on how they were scheduled.
+*/
+static int benchRegions() {
+    const int snakes = 20000;
+    const int size = 2048;
+    const int tics = 500;
+    int workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    Level level = Level::makeOpen(size, size);
+    WorkerPool pool(workers);
+    Arena serial(&level, 481);
+    Arena parallel(&level, 481, &pool);
+    for (int i = 0; i < snakes; i++) {
+        serial.addSnake(i);
+        parallel.addSnake(i);
+    }
+    std::mt19937 random(481);
+    std::uniform_int_distribution<int> choice(0, 15);
+    double serialMicros = 0;
+    double parallelMicros = 0;
+    int mismatches = 0;
+    std::vector<char> serialState;
+    std::vector<char> parallelState;
+    for (int tic = 0; tic < tics; tic++) {
+        for (int i = 0; i < snakes; i++) {
+            int turn = choice(random);
+            serial.steer(i, turn);
+            parallel.steer(i, turn);
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        serial.step();
+        serialMicros += microsSince(start);
+        start = std::chrono::steady_clock::now();
+        parallel.step();
+        parallelMicros += microsSince(start);
+        //Full states, so the bodies are compared too.
+        serialState.resize(serial.stateBound(true));
+        parallelState.resize(parallel.stateBound(true));
+        size_t serialBytes = serial.writeState(serialState.data(), true);
+        size_t parallelBytes = parallel.writeState(parallelState.data(), true);
+        if (serialBytes != parallelBytes || memcmp(serialState.data(), parallelState.data(), serialBytes) != 0) {
+            mismatches++;
+        }
+    }
+
+    char line[256];
+    snprintf(line, sizeof(line), "%d snakes on %dx%d in %d regions: %.0f us/tic on one thread, %.0f us/tic with %d workers (%.2fx), %d tics differ",
+        snakes, size, size, serial.getRegionCount(), serialMicros / tics, parallelMicros / tics, workers, serialMicros / parallelMicros, mismatches);
+    std::cout << line << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+/**
+* Step 500 snakes on a 4096x4096 arena and report how much of the chunked board got memory, then time collecting
+* the body cells in a client-sized view the way CThread draws them.
+*/
+static int benchChunks() {
+    const int snakes = 500;
+    const int size = 4096;
+    const int tics = 1000;
+    Level level = Level::makeOpen(size, size);
+    Arena arena(&level, 481);
+    std::mt19937 random(481);
+    for (int i = 0; i < snakes; i++) {
+        arena.addSnake(i);
+    }
+    std::uniform_int_distribution<int> choice(0, 15);
+    double stepMicros = 0;
+    for (int tic = 0; tic < tics; tic++) {
+        for (int i = 0; i < snakes; i++) {
+            arena.steer(i, choice(random));
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        arena.step();
+        stepMicros += microsSince(start);
+    }
+    OccupancyGrid* board = arena.getBoard();
+    int chunks = board->getMaterializedChunks();
+    //Contents and occupied bits of every chunk with memory.
+    double chunkMegabytes = chunks * (CHUNK_CELLS + CHUNK_CELLS / 8) / (1024.0 * 1024.0);
+    //The flat grid kept a content byte and two free list ints for every cell.
+    double denseMegabytes = (double)size * size * 9 / (1024.0 * 1024.0);
+
+    //A default window's worth of board around the first live snake.
+    sf::Vector2f center = level.getSpawnPosition(0);
+    for (ArenaSnake& snake : *arena.getSnakes()) {
+        if (snake.head != -1) {
+            center = board->positionOf(snake.head);
+            break;
+        }
+    }
+    sf::FloatRect view(center.x - 430.f, center.y - 322.5f, 860.f, 645.f);
+    std::vector<int> visible;
+    const int frames = 1000;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        visible.clear();
+        board->cellsIn(view, OccupancyGrid::BODY, &visible);
+    }
+    double viewMicros = microsSince(start) / frames;
+
+    char line[256];
+    snprintf(line, sizeof(line), "%d snakes on %dx%d: step %.1f us/tic, %d of %d chunks materialized (%.1f MB, flat grid %.0f MB), view %.2f us/frame (%zu cells)",
+        snakes, size, size, stepMicros / tics, chunks, board->getChunkCount(), chunkMegabytes, denseMegabytes, viewMicros, visible.size());
+    std::cout << line << std::endl;
+    return 0;
+}
+
+/**
+* Have one thread per RepThread report scores for 1000 players each, the way RepThreads report every reply, while
+* another thread publishes the leaderboard every millisecond. The old way takes one shared mutex for every score
+* that beats the high score. Time per report only shows contention on a machine with a core per thread, so the
+* reports that found their lock taken are counted too.
+*/
+static int benchLeaderboard() {
+    const int reporters = 4;
+    const int players = 1000;
+    const int reports = 500000;
+    //Scores creep up like real games, so most reports don't beat the player's best.
+    auto scoreOf = [](std::mt19937& random, int i) { return (int)(random() % (1 + i / 100)); };
+
+    std::mutex mutex;
+    int highScore = 1;
+    //Reports that found the lock taken, which is what sharding is meant to get rid of.
+    std::atomic<int64_t> mutexContended(0);
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int t = 0; t < reporters; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 random(t);
+            for (int i = 0; i < reports; i++) {
+                random();
+                int score = scoreOf(random, i);
+                std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+                if (!lock.owns_lock()) {
+                    mutexContended++;
+                    lock.lock();
+                }
+                highScore = std::max(highScore, score);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double mutexNs = microsSince(start) * 1000 / reports;
+
+    Leaderboard leaderboard(reporters);
+    std::atomic<bool> done(false);
+    int messages = 0;
+    size_t bytes = 0;
+    threads.clear();
+    start = std::chrono::steady_clock::now();
+    std::thread publisher([&]() {
+        std::string message;
+        for (int64_t tic = 1; !done; tic++) {
+            if (leaderboard.publish(tic % LEADERBOARD_FULL_TICS == 0, &message)) {
+                messages++;
+                bytes += message.size();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    for (int t = 0; t < reporters; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 random(t);
+            for (int i = 0; i < reports; i++) {
+                //Sessions are spread over RepThreads by ID, so each thread only has IDs of its own shard.
+                int id = t + reporters * (int)(random() % players);
+                leaderboard.report(id, scoreOf(random, i));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double shardedNs = microsSince(start) * 1000 / reports;
+    done = true;
+    publisher.join();
+
+    //Waits are counted over every report from every thread.
+    double total = (double)reporters * reports;
+    char line[320];
+    snprintf(line, sizeof(line), "%d threads x %d reports: one mutex %.1f ns/report (%.2f%% waited), sharded leaderboard %.1f ns/report (%.2f%% waited), %d messages averaging %zu bytes (best %d/%d)",
+        reporters, reports, mutexNs, 100.0 * mutexContended / total, shardedNs, 100.0 * leaderboard.getContended() / total,
+        messages, messages > 0 ? bytes / messages : 0, leaderboard.getBest(), highScore);
+    std::cout << line << std::endl;
+    return leaderboard.getBest() == highScore ? 0 : 1;
+}
+
+int runBench(std::string name) {
+    if (name == "collisions") {
+        return benchCollisions(HASH_CELL_SIZE);
+    }
+    //Everything in one cell, so the overlap kernel does all the work.
+    if (name == "overlap") {
+        return benchCollisions(1e7f);
+    }
+    if (name == "dispatch") {
+        return benchDispatch();
+    }
+    if (name == "grid") {
+        return benchGrid();
+    }
+    if (name == "arena") {
+        return benchArena();
+    }
+    if (name == "chunks") {
+        return benchChunks();
+    }
+    if (name == "regions") {
+        return benchRegions();
+    }
+    if (name == "leaderboard") {
+        return benchLeaderboard();
+    }
+    std::cout << "Unknown benchmark " << name << std::endl;
+    return 2;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCH_H
+#define BENCH_H
+#include <string>
+
+/**
+* Offline benchmarks run with GameBot -bench <name>. They need no server and no display.
+*
+* collisions   checkCollisions-style queries against 10 to 100k collidables: old linear scan vs SpatialHash with the
+*              scalar and the SIMD overlap kernel
+* overlap      the same with every collidable in one cell, to time the overlap kernels on their own
+* dispatch     finding the drawable of 10k objects, a dynamic_cast each vs registered pointers. No draw calls
+* grid         free-cell bookkeeping per snake tic as the board fills: list of free positions vs OccupancyGrid
+* arena        one server tic of 500 snakes in an Arena, and writing the state the server publishes
+* chunks       500 snakes on a 4096x4096 arena: chunks materialized, and collecting the body cells in view
+* regions      20k snakes on a 2048x2048 arena stepped on one thread vs split over every core, checked to match
+* leaderboard  reporting scores from 4 threads: one shared mutex vs the sharded Leaderboard, how often each made a
+*              report wait for its lock, and deltas published
+*
+* @return the exit code for main().
+*/
+int runBench(std::string name);
+
+#endif
@@ -0,0 +1,89 @@
+#include "BotStats.h"
+#include <cstdio>
+
+BotStats::BotStats() {
+    joins = 0;
+    rejoins = 0;
+    joinTotal = 0;
+    rejoinTotal = 0;
+    joinMax = 0;
+    rejoinMax = 0;
+    failedJoins = 0;
+    disconnects = 0;
+    requests = 0;
+    replies = 0;
+    updates = 0;
+    records = 0;
+    known = 0;
+    rttTotal = 0;
+    rttMax = 0;
+    serverTicTotal = 0;
+    serverTicCount = 0;
+    serverTicMax = 0;
+    botTics = 0;
+    botMicros = 0;
+    planned = 0;
+}
+
+void BotStats::recordMax(std::atomic<int64_t>* max, int64_t value) {
+    int64_t current = max->load();
+    //Someone else may raise it first, so keep trying until ours is smaller or it sticks.
+    while (value > current && !max->compare_exchange_weak(current, value)) {
+    }
+}
+
+void BotStats::recordJoin(int64_t micros, bool resumed) {
+    if (resumed) {
+        rejoins++;
+        rejoinTotal += micros;
+        recordMax(&rejoinMax, micros);
+    }
+    else {
+        joins++;
+        joinTotal += micros;
+        recordMax(&joinMax, micros);
+    }
+}
+
+void BotStats::recordReply(int64_t micros) {
+    replies++;
+    rttTotal += micros;
+    recordMax(&rttMax, micros);
+}
+
+void BotStats::recordUpdate(std::string update) {
+    updates++;
+    int highScore = 0;
+    long long ticMicros = 0;
+    if (sscanf_s(update.data(), "%d %lld", &highScore, &ticMicros) == 2 && ticMicros > 0) {
+        serverTicTotal += ticMicros;
+        serverTicCount++;
+        recordMax(&serverTicMax, ticMicros);
+    }
+}
+
+BotStats::Snapshot BotStats::snapshot() {
+    Snapshot s;
+    s.joins = joins;
+    s.rejoins = rejoins;
+    s.joinTotal = joinTotal;
+    s.rejoinTotal = rejoinTotal;
+    s.failedJoins = failedJoins;
+    s.disconnects = disconnects;
+    s.requests = requests;
+    s.replies = replies;
+    s.updates = updates;
+    s.records = records;
+    s.known = known;
+    s.rttTotal = rttTotal;
+    s.serverTicTotal = serverTicTotal;
+    s.serverTicCount = serverTicCount;
+    s.botTics = botTics;
+    s.botMicros = botMicros;
+    s.planned = planned;
+    return s;
+}
+
+int64_t BotStats::takeMax(std::atomic<int64_t>* max) {
+    return max->exchange(0);
+}
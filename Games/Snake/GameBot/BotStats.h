@@ -0,0 +1,163 @@
+#ifndef BOTSTATS_H
+#define BOTSTATS_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+* Counters shared by every bot thread. Everything is atomic so bot threads can record without locking
+* while main() reads them once a second.
+*/
+class BotStats {
+private:
+    /**
+    * Raise max to value if value is bigger.
+    */
+    static void recordMax(std::atomic<int64_t>* max, int64_t value);
+
+public:
+    /**
+    * A copy of every counter at one point in time. Subtract two of them to get the numbers for an interval.
+    */
+    struct Snapshot {
+        int64_t joins = 0;
+        int64_t rejoins = 0;
+        int64_t joinTotal = 0;
+        int64_t rejoinTotal = 0;
+        int64_t failedJoins = 0;
+        int64_t disconnects = 0;
+        int64_t requests = 0;
+        int64_t replies = 0;
+        int64_t updates = 0;
+        int64_t records = 0;
+        int64_t known = 0;
+        int64_t rttTotal = 0;
+        int64_t serverTicTotal = 0;
+        int64_t serverTicCount = 0;
+        int64_t botTics = 0;
+        int64_t botMicros = 0;
+        int64_t planned = 0;
+    };
+
+    /**
+    * Successful handshakes that started a new session.
+    */
+    std::atomic<int64_t> joins;
+
+    /**
+    * Successful handshakes that resumed the bot's old session.
+    */
+    std::atomic<int64_t> rejoins;
+
+    /**
+    * Sum of the time every join and every rejoin took, in microseconds.
+    */
+    std::atomic<int64_t> joinTotal;
+    std::atomic<int64_t> rejoinTotal;
+
+    /**
+    * Longest join and rejoin since the last takeMax(), in microseconds.
+    */
+    std::atomic<int64_t> joinMax;
+    std::atomic<int64_t> rejoinMax;
+
+    /**
+    * Handshakes that timed out or got a bad reply.
+    */
+    std::atomic<int64_t> failedJoins;
+
+    /**
+    * Replies that never came back within the timeout.
+    */
+    std::atomic<int64_t> disconnects;
+
+    /**
+    * Score messages sent.
+    */
+    std::atomic<int64_t> requests;
+
+    /**
+    * Replies received.
+    */
+    std::atomic<int64_t> replies;
+
+    /**
+    * Publisher updates received.
+    */
+    std::atomic<int64_t> updates;
+
+    /**
+    * Other-player records received in replies.
+    */
+    std::atomic<int64_t> records;
+
+    /**
+    * Sum over every reply of the number of other players the bot knew about after it.
+    */
+    std::atomic<int64_t> known;
+
+    /**
+    * Sum of every round trip, in microseconds.
+    */
+    std::atomic<int64_t> rttTotal;
+
+    /**
+    * Longest round trip since the last takeMax(), in microseconds.
+    */
+    std::atomic<int64_t> rttMax;
+
+    /**
+    * Sum of the tic durations the server published (the time it spent stepping and publishing), in microseconds.
+    */
+    std::atomic<int64_t> serverTicTotal;
+
+    /**
+    * Number of tic durations summed in serverTicTotal.
+    */
+    std::atomic<int64_t> serverTicCount;
+
+    /**
+    * Longest published tic since the last takeMax(), in microseconds.
+    */
+    std::atomic<int64_t> serverTicMax;
+
+    /**
+    * Tics stepped by all bot threads together, and the time they spent on them, in microseconds, not counting
+    * planning. Planning time is kept by the PlannerPool.
+    */
+    std::atomic<int64_t> botTics;
+    std::atomic<int64_t> botMicros;
+
+    /**
+    * Bot moves planned.
+    */
+    std::atomic<int64_t> planned;
+
+    BotStats();
+
+    /**
+    * Record one successful handshake that took micros microseconds.
+    */
+    void recordJoin(int64_t micros, bool resumed);
+
+    /**
+    * Record one reply that took micros microseconds.
+    */
+    void recordReply(int64_t micros);
+
+    /**
+    * Record one publisher update. Updates are "<highScore> <ticMicros>".
+    */
+    void recordUpdate(std::string update);
+
+    /**
+    * Copy the counters.
+    */
+    Snapshot snapshot();
+
+    /**
+    * Return the maximum and reset it to 0, so each report shows the worst case of its own interval.
+    */
+    static int64_t takeMax(std::atomic<int64_t>* max);
+};
+#endif
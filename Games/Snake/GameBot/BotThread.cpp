@@ -0,0 +1,226 @@
+#include "BotThread.h"
+
+BotClosedHandler::BotClosedHandler(bool* finished) {
+    this->finished = finished;
+}
+
+void BotClosedHandler::onEvent(Event e) {
+    *finished = true;
+}
+
+BotThread::BotThread(Transport* transport, Timeline* timeline, const Level* level, PlannerPool* planners, BotStats* stats,
+    std::atomic<bool>* stopped, int numBots, std::string pattern, int timeout, int churn, int budget, unsigned int seed)
+    : random(seed)
+{
+    this->transport = transport;
+    this->line = timeline;
+    this->level = level;
+    this->planners = planners;
+    this->stats = stats;
+    this->stopped = stopped;
+    this->numBots = numBots;
+    this->pattern = pattern;
+    this->timeout = timeout;
+    this->churn = churn;
+    this->budget = budget;
+}
+
+BotThread::~BotThread() {
+    for (Bot* bot : bots) {
+        delete bot->connection;
+        delete bot->em;
+        delete bot->view;
+        delete bot;
+    }
+}
+
+bool BotThread::join(Bot* bot) {
+    bot->awaitingReply = false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (bot->connection->join(timeout)) {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        stats->recordJoin(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), bot->connection->wasResumed());
+        return true;
+    }
+    stats->failedJoins++;
+    return false;
+}
+
+int BotThread::nextDirection(Bot* bot, int planned) {
+    int direction = planned;
+    if (!pattern.empty()) {
+        char next = pattern[bot->patternIndex];
+        bot->patternIndex = (bot->patternIndex + 1) % pattern.size();
+        switch (next) {
+        case 'U': direction = Arena::UP; break;
+        case 'D': direction = Arena::DOWN; break;
+        case 'L': direction = Arena::LEFT; break;
+        case 'R': direction = Arena::RIGHT; break;
+        default: direction = -1; break;
+        }
+    }
+    return direction;
+}
+
+int BotThread::nearestApple(Bot* bot, int head) {
+    int columns = bot->view->getBoard()->getColumns();
+    int best = -1;
+    int bestDistance = 0;
+    for (int apple : *bot->view->getApples()) {
+        int distance = abs(apple % columns - head % columns) + abs(apple / columns - head / columns);
+        if (best == -1 || distance < bestDistance) {
+            best = apple;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+PlanRequest BotThread::planRequest(Bot* bot) {
+    const BoardSnake* snake = bot->view->getSnake(bot->connection->getID());
+    if (!bot->view->isSynced() || snake == nullptr || snake->head == -1) {
+        return { bot->view->getBoard(), -1, -1, -1, -1 };
+    }
+    return { bot->view->getBoard(), snake->head, nearestApple(bot, snake->head), snake->body.back(), -1 };
+}
+
+void BotThread::handleReply(Bot* bot, std::string reply, int64_t time) {
+    //Most replies are just "Connected". Skip the parse (and the Event it allocates) for those.
+    if (reply == "Connected") {
+        return;
+    }
+    try {
+        std::shared_ptr<Event> e(new Event);
+        //Convert to an event pointer
+        e = (std::dynamic_pointer_cast<Event>(e->constructSelf(reply)));
+        e->time = time + e->time;
+        //Raise event
+        bot->em->raise(*e);
+    }
+    catch (std::invalid_argument) {
+        //Oops, wasn't an event.
+    }
+}
+
+void BotThread::run() {
+    for (int i = 0; i < numBots; i++) {
+        Bot* bot = new Bot;
+        bot->em = new EventManager(line);
+        bot->connection = new ClientConnection(transport);
+        bot->connection->setBudget(budget);
+        bot->view = new BoardView(level);
+        bot->connection->setBoardView(bot->view);
+
+        std::string type("Client_Closed");
+        std::list<std::string> types;
+        types.push_back(type);
+        bot->em->registerEvent(types, new BotClosedHandler(&bot->finished));
+
+        join(bot);
+        bots.push_back(bot);
+    }
+
+    int64_t tic = 0;
+    int64_t currentTic;
+    std::vector<zmq::pollitem_t> items;
+    std::vector<Bot*> waiting;
+
+    while (!(*stopped)) {
+        currentTic = line->getTime();
+        if (currentTic > tic) {
+            std::chrono::steady_clock::time_point ticStart = std::chrono::steady_clock::now();
+            requests.clear();
+            planned.clear();
+            for (Bot* bot : bots) {
+                if (bot->finished) {
+                    continue;
+                }
+                //Retry bots that couldn't get in.
+                if (bot->connection->getID() < 0 && !join(bot)) {
+                    continue;
+                }
+                std::string update;
+                while (bot->connection->receiveUpdate(&update, 0)) {
+                    stats->recordUpdate(update);
+                }
+                //Simulate a client that stalls and comes back.
+                if (churn > 0 && std::uniform_int_distribution<int>(0, churn - 1)(random) == 0 && !join(bot)) {
+                    continue;
+                }
+                //Plan it with everyone else's below.
+                bot->connection->receiveBoard();
+                requests.push_back(planRequest(bot));
+                planned.push_back(bot);
+            }
+
+            //Every bot's move in one batch. The pool's time is counted separately.
+            std::chrono::steady_clock::time_point planStart = std::chrono::steady_clock::now();
+            if (pattern.empty()) {
+                planners->plan(&requests, &planner);
+                stats->planned += requests.size();
+            }
+            std::chrono::steady_clock::time_point planEnd = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < planned.size(); i++) {
+                Bot* bot = planned[i];
+                //Still waiting on last tic's reply, don't send another.
+                if (!bot->awaitingReply) {
+                    bot->connection->sendInput(nextDirection(bot, requests[i].direction));
+                    bot->sentAt = std::chrono::steady_clock::now();
+                    bot->awaitingReply = true;
+                    stats->requests++;
+                }
+            }
+            stats->botTics++;
+            stats->botMicros += std::chrono::duration_cast<std::chrono::microseconds>(
+                (std::chrono::steady_clock::now() - ticStart) - (planEnd - planStart)).count();
+            tic = currentTic;
+        }
+
+        //Wait on every outstanding request at once.
+        items.clear();
+        waiting.clear();
+        for (Bot* bot : bots) {
+            if (bot->awaitingReply) {
+                items.push_back({ bot->connection->getReplyHandle(), 0, ZMQ_POLLIN, 0 });
+                waiting.push_back(bot);
+            }
+        }
+        if (items.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        zmq::poll(items.data(), items.size(), std::chrono::milliseconds(1));
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < waiting.size(); i++) {
+            Bot* bot = waiting[i];
+            if (items[i].revents & ZMQ_POLLIN) {
+                std::string reply;
+                bot->connection->receiveReply(&reply, 0);
+                bot->awaitingReply = false;
+                stats->recordReply(std::chrono::duration_cast<std::chrono::microseconds>(now - bot->sentAt).count());
+                stats->records += bot->connection->getLastRecords();
+                stats->known += bot->connection->getPlayers()->size();
+                handleReply(bot, reply, line->convertGlobal(line->getTime()));
+            }
+            else if (now - bot->sentAt > std::chrono::milliseconds(timeout)) {
+                //The server dropped us or is too far behind. Count it and get back in.
+                stats->disconnects++;
+                join(bot);
+            }
+        }
+    }
+
+    //Tell the server every bot is leaving.
+    for (Bot* bot : bots) {
+        if (bot->connection->getID() >= 0) {
+            //A request socket can't send again until it has its reply.
+            std::string reply;
+            if (bot->awaitingReply && !bot->connection->receiveReply(&reply, timeout)) {
+                continue;
+            }
+            bot->connection->leave(timeout);
+        }
+    }
+}
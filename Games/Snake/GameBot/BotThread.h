@@ -0,0 +1,137 @@
+#ifndef BOTTHREAD_H
+#define BOTTHREAD_H
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <string>
+#include <vector>
+#include "ClientConnection.h"
+#include "Arena.h"
+#include "BoardView.h"
+#include "EventManager.h"
+#include "Timeline.h"
+#include "Transport.h"
+#include "BotStats.h"
+#include "Level.h"
+#include "PlannerPool.h"
+
+/**
+* One simulated player.
+*/
+struct Bot {
+    EventManager* em;
+    ClientConnection* connection;
+    /**
+    * The room's board as the server publishes it. The bot plans its moves on it.
+    */
+    BoardView* view;
+    /**
+    * Position in the input pattern.
+    */
+    size_t patternIndex = 0;
+    /**
+    * True while an input has been sent and the reply hasn't arrived.
+    */
+    bool awaitingReply = false;
+    std::chrono::steady_clock::time_point sentAt;
+    /**
+    * Set when the server says the game is over.
+    */
+    bool finished = false;
+};
+
+/**
+* Marks a bot as finished when the server sends Client_Closed, instead of exiting like the windowed client does.
+*/
+class BotClosedHandler : public EventHandler {
+private:
+    bool* finished;
+public:
+    BotClosedHandler(bool* finished);
+
+    void onEvent(Event e) override;
+};
+
+/**
+* Runs a group of headless players on one thread. Each bot speaks the same protocol as CThread through
+* ClientConnection: it follows its room's board with a BoardView and sends the server only the direction it steers
+* its snake in, so no display is needed and the server's arena does all the playing.
+* Unless they are given a pattern, bots play: every tic the moves of all of the thread's bots are planned on their
+* views toward the nearest apple in one batch on the shared PlannerPool.
+*/
+class BotThread {
+private:
+    Transport* transport;
+    Timeline* line;
+    /**
+    * The level the server plays on, which every bot's view is made from.
+    */
+    const Level* level;
+    PlannerPool* planners;
+    /**
+    * This thread's own planner, for its share of each batch.
+    */
+    PathPlanner planner;
+    /**
+    * This tic's plan requests, one per playing bot, and the bots they are for. Reused every tic.
+    */
+    std::vector<PlanRequest> requests;
+    std::vector<Bot*> planned;
+    BotStats* stats;
+    std::atomic<bool>* stopped;
+    int numBots;
+    /**
+    * Inputs to repeat, one character per tic: U, D, L, R, or '.' to keep going. Empty means the bots plan their moves.
+    */
+    std::string pattern;
+    /**
+    * Milliseconds to wait for a reply before counting a disconnect and rejoining.
+    */
+    int timeout;
+    /**
+    * Each bot drops its connection without leaving once every this many tics on average, then resumes. 0 is off.
+    */
+    int churn;
+    /**
+    * Bytes of other players each bot asks for per tic. 0 takes the server default.
+    */
+    int budget;
+    std::vector<Bot*> bots;
+    std::mt19937 random;
+
+    /**
+    * Handshake (or resume) and record the result and how long it took.
+    */
+    bool join(Bot* bot);
+
+    /**
+    * Return the direction the bot goes this tic, or -1 to keep going.
+    * @param planned the direction planned for the bot, or -1 to keep going. Ignored if there is a pattern.
+    */
+    int nextDirection(Bot* bot, int planned);
+
+    /**
+    * Return the apple on the bot's view closest to its head, or -1 if there is none.
+    */
+    int nearestApple(Bot* bot, int head);
+
+    /**
+    * Plan request for a bot. The head is -1 until its snake is on the view.
+    */
+    PlanRequest planRequest(Bot* bot);
+
+    /**
+    * Deal with a reply from the server the same way CThread does.
+    */
+    void handleReply(Bot* bot, std::string reply, int64_t time);
+
+public:
+    BotThread(Transport* transport, Timeline* timeline, const Level* level, PlannerPool* planners, BotStats* stats,
+        std::atomic<bool>* stopped, int numBots, std::string pattern, int timeout, int churn, int budget, unsigned int seed);
+
+    ~BotThread();
+
+    void run();
+};
+#endif
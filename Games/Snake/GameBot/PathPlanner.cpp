@@ -0,0 +1,92 @@
+#include "PathPlanner.h"
+#include <algorithm>
+#include <cstdlib>
+#include "Handlers.h"
+
+//Columns and rows moved by each MovementHandler::DIRECTION.
+static const int moveX[] = { -1, 1, 0, 0 };
+static const int moveY[] = { 0, 0, -1, 1 };
+
+int PathPlanner::plan(const OccupancyGrid* board, int head, int target, int tail) {
+    if (head < 0) {
+        return -1;
+    }
+    int columns = board->getColumns();
+    int headColumn = head % columns;
+    int headRow = head / columns;
+    int targetColumn = target < 0 ? headColumn : target % columns;
+    int targetRow = target < 0 ? headRow : target / columns;
+
+    //The window around the head, clipped to the board.
+    int left = std::max(0, headColumn - PLAN_RADIUS);
+    int top = std::max(0, headRow - PLAN_RADIUS);
+    int right = std::min(columns, headColumn + PLAN_RADIUS + 1);
+    int bottom = std::min(board->getRows(), headRow + PLAN_RADIUS + 1);
+    int width = right - left;
+    int cells = width * (bottom - top);
+    if ((int)seen.size() < cells) {
+        seen.resize(cells, 0);
+        parent.resize(cells);
+    }
+    if (++stamp == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        stamp = 1;
+    }
+
+    int start = (headRow - top) * width + (headColumn - left);
+    queue.clear();
+    queue.push_back(start);
+    seen[start] = stamp;
+    int best = start;
+    int bestDistance = std::abs(headColumn - targetColumn) + std::abs(headRow - targetRow);
+    for (size_t i = 0; i < queue.size() && bestDistance > 0; i++) {
+        int current = queue[i];
+        int column = current % width + left;
+        int row = current / width + top;
+        //The first cell reached at a distance is also the closest by path, so only a strictly closer one wins.
+        int distance = std::abs(column - targetColumn) + std::abs(row - targetRow);
+        if (distance < bestDistance) {
+            best = current;
+            bestDistance = distance;
+        }
+        for (int direction = MovementHandler::LEFT; direction <= MovementHandler::DOWN; direction++) {
+            int nextColumn = column + moveX[direction];
+            int nextRow = row + moveY[direction];
+            if (nextColumn < left || nextColumn >= right || nextRow < top || nextRow >= bottom) {
+                continue;
+            }
+            int next = (nextRow - top) * width + (nextColumn - left);
+            if (seen[next] == stamp) {
+                continue;
+            }
+            int cell = nextRow * columns + nextColumn;
+            OccupancyGrid::CONTENT content = board->contentAt(cell);
+            if ((content == OccupancyGrid::WALL || content == OccupancyGrid::BODY || content == OccupancyGrid::SNAKE) && cell != tail) {
+                continue;
+            }
+            seen[next] = stamp;
+            parent[next] = current;
+            queue.push_back(next);
+        }
+    }
+
+    //Nothing closer can be reached. Any safe neighbor beats running into something.
+    if (best == start) {
+        if (queue.size() < 2) {
+            return -1;
+        }
+        best = queue[1];
+    }
+    //Walk back to the first step.
+    while (parent[best] != start) {
+        best = parent[best];
+    }
+    int dx = best % width + left - headColumn;
+    int dy = best / width + top - headRow;
+    for (int direction = MovementHandler::LEFT; direction <= MovementHandler::DOWN; direction++) {
+        if (moveX[direction] == dx && moveY[direction] == dy) {
+            return direction;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,45 @@
+#ifndef PATHPLANNER_H
+#define PATHPLANNER_H
+#include <cstdint>
+#include <vector>
+#include "OccupancyGrid.h"
+
+//Columns and rows a planner looks in each way from the head. The search never looks at more than
+//(2 * PLAN_RADIUS + 1)^2 cells, however big the board is.
+#define PLAN_RADIUS 24
+
+/**
+* Picks a bot's next move with a breadth first search over its board. Walls and bodies are blocked, except the
+* tail, which moves off its cell this tic. The search stays inside a square around the head and heads for the
+* reachable cell closest to the target, which is the target itself whenever there is a path to it.
+* The search buffers are kept between calls and only grow, so planning doesn't allocate once warmed up.
+* One planner per thread.
+*/
+class PathPlanner {
+private:
+    /**
+    * seen[i] == stamp if cell i of the window has been reached this search. Bumping stamp clears it.
+    */
+    std::vector<uint32_t> seen;
+    uint32_t stamp = 0;
+
+    /**
+    * The window cell each reached cell was reached from.
+    */
+    std::vector<int> parent;
+
+    /**
+    * Window cells in the order they were reached.
+    */
+    std::vector<int> queue;
+
+public:
+    /**
+    * Return the direction (a MovementHandler::DIRECTION) the snake with this head should take to get closer to
+    * target, or -1 if it is dead or there is nowhere safe to go.
+    * @param tail the cell the tail is in, or -1 if the snake has no body.
+    */
+    int plan(const OccupancyGrid* board, int head, int target, int tail);
+};
+
+#endif
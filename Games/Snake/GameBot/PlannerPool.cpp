@@ -0,0 +1,92 @@
+#include "PlannerPool.h"
+#include <algorithm>
+#include <chrono>
+
+PlannerPool::PlannerPool(int threads) : planners(std::max(0, threads)) {
+    busyMicros = 0;
+    for (int i = 0; i < threads; i++) {
+        this->threads.emplace_back(&PlannerPool::run, this, i);
+    }
+}
+
+PlannerPool::~PlannerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    workReady.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void PlannerPool::work(Batch* batch, PathPlanner* planner) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<PlanRequest>& requests = *batch->requests;
+    int size = (int)requests.size();
+    while (true) {
+        int first = batch->next.fetch_add(PLAN_CHUNK);
+        if (first >= size) {
+            break;
+        }
+        int last = std::min(size, first + PLAN_CHUNK);
+        for (int i = first; i < last; i++) {
+            PlanRequest& request = requests[i];
+            request.direction = planner->plan(request.board, request.head, request.target, request.tail);
+        }
+        batch->finished += last - first;
+    }
+    busyMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PlannerPool::run(int i) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workReady.wait(lock, [this]() { return stopped || !batches.empty(); });
+        if (stopped) {
+            return;
+        }
+        //Help with the oldest batch. Once everything in it is taken, nobody else needs to look at it.
+        Batch* batch = batches.front();
+        if (batch->next >= (int)batch->requests->size()) {
+            batches.pop_front();
+            continue;
+        }
+        batch->users++;
+        lock.unlock();
+        work(batch, &planners[i]);
+        lock.lock();
+        batch->users--;
+        batchDone.notify_all();
+    }
+}
+
+void PlannerPool::plan(std::vector<PlanRequest>* requests, PathPlanner* planner) {
+    if (requests->empty()) {
+        return;
+    }
+    Batch batch;
+    batch.requests = requests;
+    batch.next = 0;
+    batch.finished = 0;
+    if (!threads.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(&batch);
+        }
+        workReady.notify_all();
+    }
+    work(&batch, planner);
+    if (threads.empty()) {
+        return;
+    }
+
+    //Everything is taken. Wait for pool threads still planning what they took, and for them to let go of it.
+    std::unique_lock<std::mutex> lock(mutex);
+    batches.remove(&batch);
+    batchDone.wait(lock, [&]() { return batch.users == 0 && batch.finished == (int)requests->size(); });
+}
+
+int64_t PlannerPool::getBusyMicros() {
+    return busyMicros;
+}
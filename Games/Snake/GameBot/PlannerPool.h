@@ -0,0 +1,102 @@
+#ifndef PLANNERPOOL_H
+#define PLANNERPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PathPlanner.h"
+
+//Requests a thread takes from a batch at a time.
+#define PLAN_CHUNK 16
+
+/**
+* One bot's move to plan. direction is filled in with the result of PathPlanner::plan().
+*/
+struct PlanRequest {
+    const OccupancyGrid* board;
+    int head;
+    int target;
+    int tail;
+    int direction;
+};
+
+/**
+* Threads that plan bot moves a batch at a time. Every BotThread hands over all of its bots' requests for a tic
+* at once with plan(), and the pool's threads and the BotThread itself split the batch PLAN_CHUNK requests at a
+* time. Each thread has its own PathPlanner, so the search buffers are reused from tic to tic and never shared.
+*/
+class PlannerPool {
+private:
+    /**
+    * A batch being planned. Lives on the stack of the plan() call that made it.
+    */
+    struct Batch {
+        std::vector<PlanRequest>* requests;
+        /**
+        * First request nobody has taken yet, and the number of requests planned.
+        */
+        std::atomic<int> next;
+        std::atomic<int> finished;
+        /**
+        * Pool threads working on the batch. Protected by mutex.
+        */
+        int users = 0;
+    };
+
+    std::mutex mutex;
+    /**
+    * Signalled when a batch is queued or the pool stops, and when a pool thread is done with a batch.
+    */
+    std::condition_variable workReady;
+    std::condition_variable batchDone;
+    /**
+    * Batches that may still have requests nobody has taken. Protected by mutex.
+    */
+    std::list<Batch*> batches;
+    bool stopped = false;
+
+    std::vector<std::thread> threads;
+    std::vector<PathPlanner> planners;
+
+    /**
+    * Time spent planning by every thread, in microseconds.
+    */
+    std::atomic<int64_t> busyMicros;
+
+    /**
+    * Plan requests from the batch until there are none left.
+    */
+    void work(Batch* batch, PathPlanner* planner);
+
+    /**
+    * Body of pool thread i.
+    */
+    void run(int i);
+
+public:
+    /**
+    * Start a pool with the given number of threads. 0 threads is allowed: plan() then does all the work itself.
+    */
+    PlannerPool(int threads);
+
+    /**
+    * Stop and join the threads.
+    */
+    ~PlannerPool();
+
+    /**
+    * Plan every request, using the pool's threads and the calling thread, and return when all are done.
+    * @param planner the calling thread's own planner.
+    */
+    void plan(std::vector<PlanRequest>* requests, PathPlanner* planner);
+
+    /**
+    * Return the time spent planning so far by every thread together, in microseconds.
+    */
+    int64_t getBusyMicros();
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include <zmq.hpp>
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <list>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "Timeline.h"
+#include "EventManager.h"
+#include "Transport.h"
+#include "Server.h"
+#include "BotThread.h"
+#include "BotStats.h"
+#include "PlannerPool.h"
+#include "Bench.h"
+
+#define TIC 75
+
+/**
+* Run a group of bots
+*/
+void run_bots(BotThread* fe) {
+    fe->run();
+}
+
+/**
+* Run an in-process server
+*/
+void run_server(Server* fe) {
+    fe->run();
+}
+
+/**
+* Headless load generator. Runs any number of simulated players in a server's arena and prints what they see
+* once a second. Needs no window or display, so it can run unattended.
+*
+* Options:
+*   -bots N       total number of players (default 100)
+*   -threads N    threads to spread the players over (default 4)
+*   -seconds N    how long to run, 0 runs until killed (default 60)
+*   -pattern STR  repeat these inputs, one per tic: U D L R, or . for none (default: plan a path to the apple)
+*   -planners N   threads planning bot moves, next to the bot threads themselves (default 2)
+*   -timeout MS   how long to wait for a reply before counting a disconnect (default 2000)
+*   -churn N      each bot drops and resumes its session once every N tics on average (default off)
+*   -budget N     bytes of other players each bot asks for per tic (default: server decides)
+*   -inproc       host the server in this process and talk to it over inproc instead of TCP
+*   -arena N      play on an N x N arena instead of the client's 39x29 board. CxR for C columns by R rows.
+*   -rooms N      with -inproc, host N rooms. Bots fill them ROOM_PLAYERS at a time (default 1)
+*   -bench NAME   run an offline benchmark (see Bench.h) and exit
+*/
+int main(int argc, char** argv) {
+    int numBots = 100;
+    int numThreads = 4;
+    int seconds = 60;
+    int timeout = 2000;
+    int churn = 0;
+    int budget = 0;
+    int numPlanners = 2;
+    int rooms = 1;
+    std::string bench;
+    std::string pattern;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-bots") == 0 && i + 1 < argc) {
+            numBots = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-pattern") == 0 && i + 1 < argc) {
+            pattern = argv[++i];
+        }
+        else if (strcmp(argv[i], "-timeout") == 0 && i + 1 < argc) {
+            timeout = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-churn") == 0 && i + 1 < argc) {
+            churn = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-budget") == 0 && i + 1 < argc) {
+            budget = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-bench") == 0 && i + 1 < argc) {
+            bench = argv[++i];
+        }
+        else if (strcmp(argv[i], "-planners") == 0 && i + 1 < argc) {
+            numPlanners = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-rooms") == 0 && i + 1 < argc) {
+            rooms = atoi(argv[++i]);
+        }
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    if (numThreads > numBots) {
+        numThreads = numBots;
+    }
+
+    if (!bench.empty()) {
+        return runBench(bench);
+    }
+
+    Timeline globalTime;
+    Timeline botTime(&globalTime, TIC);
+
+    //With -inproc the server runs in this process and every message stays in memory.
+    Transport transport(Transport::parseMode(argc, argv));
+    Timeline serverTime(&globalTime, TIC);
+    EventManager serverManager(&globalTime);
+    //The bots play on the same level as the server.
+    Level level = Level::parseArena(argc, argv);
+    Server server(&transport, &serverTime, &serverManager, level, rooms);
+    std::thread serverThread;
+    if (transport.getMode() == Transport::INPROC) {
+        serverThread = std::thread(run_server, &server);
+    }
+
+    //Split the bots as evenly as possible. Their moves are planned on one shared pool.
+    PlannerPool planners(std::max(0, numPlanners));
+    BotStats stats;
+    std::atomic<bool> stopped;
+    stopped = false;
+    std::vector<BotThread*> botThreads;
+    std::vector<std::thread*> threads;
+    for (int i = 0; i < numThreads; i++) {
+        int count = numBots / numThreads + (i < numBots % numThreads ? 1 : 0);
+        BotThread* botThread = new BotThread(&transport, &botTime, &level, &planners, &stats, &stopped, count, pattern, timeout, churn, budget, 1000 + i);
+        botThreads.push_back(botThread);
+        threads.push_back(new std::thread(run_bots, botThread));
+    }
+
+    //Report once a second.
+    BotStats::Snapshot last = stats.snapshot();
+    int64_t lastPlanMicros = planners.getBusyMicros();
+    for (int elapsed = 1; seconds == 0 || elapsed <= seconds; elapsed++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        BotStats::Snapshot now = stats.snapshot();
+        int64_t replies = now.replies - last.replies;
+        int64_t ticCount = now.serverTicCount - last.serverTicCount;
+        int64_t joins = now.joins - last.joins;
+        int64_t rejoins = now.rejoins - last.rejoins;
+        //What the bots cost per tic, so it can be taken off what the server measured on the same machine.
+        int64_t planMicros = planners.getBusyMicros() - lastPlanMicros;
+        int64_t planned = now.planned - last.planned;
+        double tics = (double)(now.botTics - last.botTics) / numThreads;
+        char line[640];
+        snprintf(line, sizeof(line),
+            "%4ds joins %lld avg %.2fms max %.2fms (failed %lld) rejoins %lld avg %.2fms max %.2fms disconnects %lld"
+            " | req/s %lld rep/s %lld upd/s %lld | players/reply %.1f known %.1f"
+            " | rtt avg %.2fms max %.2fms | server tic avg %.2fms max %.2fms"
+            " | bots %.2fms/tic plan %.2fms/tic (%.1fus/move)",
+            elapsed, (long long)joins, joins > 0 ? (now.joinTotal - last.joinTotal) / 1000.0 / joins : 0.0,
+            BotStats::takeMax(&stats.joinMax) / 1000.0, (long long)(now.failedJoins - last.failedJoins),
+            (long long)rejoins, rejoins > 0 ? (now.rejoinTotal - last.rejoinTotal) / 1000.0 / rejoins : 0.0,
+            BotStats::takeMax(&stats.rejoinMax) / 1000.0,
+            (long long)(now.disconnects - last.disconnects), (long long)(now.requests - last.requests),
+            (long long)replies, (long long)(now.updates - last.updates),
+            replies > 0 ? (double)(now.records - last.records) / replies : 0.0,
+            replies > 0 ? (double)(now.known - last.known) / replies : 0.0,
+            replies > 0 ? (now.rttTotal - last.rttTotal) / 1000.0 / replies : 0.0,
+            BotStats::takeMax(&stats.rttMax) / 1000.0,
+            ticCount > 0 ? (now.serverTicTotal - last.serverTicTotal) / 1000.0 / ticCount : 0.0,
+            BotStats::takeMax(&stats.serverTicMax) / 1000.0,
+            tics > 0 ? (now.botMicros - last.botMicros) / 1000.0 / tics : 0.0, tics > 0 ? planMicros / 1000.0 / tics : 0.0,
+            planned > 0 ? (double)planMicros / planned : 0.0);
+        std::cout << line << std::endl;
+        last = now;
+        lastPlanMicros += planMicros;
+    }
+
+    stopped = true;
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i]->join();
+        delete threads[i];
+        delete botThreads[i];
+    }
+    if (serverThread.joinable()) {
+        server.stop();
+        serverThread.join();
+    }
+
+    BotStats::Snapshot total = stats.snapshot();
+    std::cout << "total joins " << total.joins << " rejoins " << total.rejoins << " failed joins " << total.failedJoins << " disconnects " << total.disconnects
+        << " requests " << total.requests << " replies " << total.replies << " updates " << total.updates << std::endl;
+    return 0;
+}
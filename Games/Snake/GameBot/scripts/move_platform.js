@@ -0,0 +1,8 @@
+// 
+// A gentle introduction, using the print callback registered in the native
+// main() function
+//
+//This better be the moving platform
+var obj = moreArgs();
+obj.x = obj.x + obj.speedX * obj.scale;
+obj.y = obj.y + obj.speedY * obj.scale;
\ No newline at end of file
@@ -2,10 +2,9 @@
 #define CTHREAD_H
 //Correct version
 #include <thread>
+#include <atomic>
 #include <condition_variable>
 #include <zmq.hpp>
-#include <v8.h>
-#include <libplatform/libplatform.h>
 
 #include "MovingPlatform.h"
 #include "Timeline.h"
@@ -15,11 +14,16 @@
 #include "Event.h"
 #include "EventManager.h"
 #include "Handlers.h"
+#include "Transport.h"
+#include "ClientConnection.h"
+#include "BoardView.h"
+#include "Level.h"
 
-#define JUMP_SPEED 420.f
-
-#define JUMP_TIME .5
 #define MESSAGE_LIMIT 1024
+//Milliseconds to wait on the server before resuming the session.
+#define REPLY_TIMEOUT 2000
+//Places of the leaderboard drawn under the board.
+#define LEADERS_SHOWN 3
 
 
 class CThread
@@ -48,15 +52,19 @@ class CThread
     Timeline *line;
 
     /**
-    * The window that the character and it's colliding objects are in.
+    * The window the board is drawn in.
     */
     GameWindow *window;
 
     /**
-    * This is a boolean that main will need to use to know if it's okay for
-    * the character to jump or not.
+    * The level the server's rooms are played on. The board is rebuilt on it.
+    */
+    const Level* level;
+
+    /**
+    * The direction (an Arena::DIRECTION) the player last pressed, set by main. -1 once it has been sent.
     */
-    bool *upPressed;
+    std::atomic<int>* input;
 
     /**
     * boolean for synchronization
@@ -65,6 +73,11 @@ class CThread
 
     EventManager* em;
 
+    /**
+    * The transport used to reach the server.
+    */
+    Transport* transport;
+
 
 
 
@@ -72,10 +85,11 @@ class CThread
         /**
         * Create a new CThread an d initialize all of the fields.
         */
-        CThread(bool* upPressed, GameWindow* window, Timeline* timeline, bool* stopped,
-            std::mutex* m, std::condition_variable* cv, bool *busy, EventManager *);
+        CThread(std::atomic<int>* input, GameWindow* window, const Level* level, Timeline* timeline, bool* stopped,
+            std::mutex* m, std::condition_variable* cv, bool *busy, EventManager *, Transport* transport);
         /**
-        * Run the thread
+        * Run the thread. Every tic it sends the player's input to the server and draws the room's board as the
+        * server last published it. The game itself is played in the server's arena.
         */
         void run();
 
@@ -0,0 +1,20 @@
+#include "RenderThread.h"
+
+RenderThread::RenderThread(GameWindow* window, bool* stopped) {
+    this->window = window;
+    this->stop = stopped;
+}
+
+void RenderThread::run() {
+    window->setActive(true);
+    while (!(*stop)) {
+        if (window->renderFrame()) {
+            window->display();
+        }
+        else {
+            //Nothing new yet. The simulation publishes once a tic.
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    window->setActive(false);
+}
@@ -0,0 +1,32 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+#include <thread>
+#include <chrono>
+#include "GameWindow.h"
+
+/**
+* Draws the frames CThread publishes and displays them. The only thread the window is active on, so vsync or a
+* slow driver only ever holds this thread up. It reads nothing but the snapshots GameWindow hands over, and
+* takes none of the simulation's locks.
+*/
+class RenderThread
+{
+    /**
+    * The window to draw. Must not be active on any other thread.
+    */
+    GameWindow* window;
+
+    /**
+    * Set *stop to true to make run() return.
+    */
+    bool* stop;
+
+public:
+    RenderThread(GameWindow* window, bool* stopped);
+
+    /**
+    * Draw every new frame until stopped. Releases the window before returning.
+    */
+    void run();
+};
+#endif
@@ -2,12 +2,17 @@
 #include "Character.h"
 #include "GameWindow.h"
 #include "CThread.h"
+#include "RenderThread.h"
 #include "DeathZone.h"
 #include "SideBound.h"
 #include <v8.h>
 #include "v8helpers.h"
 #include "ScriptManager.h"
+#include "Server.h"
 #include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
 #include <libplatform/libplatform.h>
 #define V8_COMPRESS_POINTERS 1
 #define V8_31BIT_SMIS_ON_64BIT_ARCH 1
@@ -46,93 +51,48 @@ void run_cthread(CThread *fe) {
     fe->run();
 }
 
+/**
+* Run the RenderThread
+*/
+void run_render(RenderThread *fe) {
+    fe->run();
+}
+
+/**
+* Run an in-process server
+*/
+void run_server(Server *fe) {
+    fe->run();
+}
+
 
 int main(int argc, char **argv) {
+        //Once for the whole run. Handlers that place apples with randomFree() don't seed it again.
+        srand((unsigned int)time(NULL));
 
-        GameWindow window;
+        //The objects and collisions. The window only draws them.
+        World world;
+        GameWindow window(&world);
 
         sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
         window.create(sf::VideoMode(800, 600), "Window", sf::Style::Default);
-        window.setView(sf::View(sf::FloatRect(0, 0, 860, 645)));
+        window.requestView(sf::View(sf::FloatRect(0, 0, 860, 645)));
+        window.loadFont("superstar_memesbruh03.ttf");
+        //The render thread draws from here on.
         window.setActive(false);
 
-        //Create StartPlatform and add it to the window
-        Platform bottom;
-        bottom.setSize(sf::Vector2f(800, 10.f));
-        bottom.setFillColor(sf::Color(100, 0, 0));
-        bottom.setPosition(sf::Vector2f(0, 590));
-        window.addGameObject(&bottom);
-
-        Platform right;
-        right.setSize(sf::Vector2f(10, 580));
-        right.setFillColor(sf::Color(100, 0, 0));
-        right.setPosition(sf::Vector2f(790, 10));
-        window.addGameObject(&right);
-
-        Platform left;
-        left.setSize(sf::Vector2f(10, 580));
-        left.setFillColor(sf::Color(100, 0, 0));
-        left.setPosition(sf::Vector2f(0, 10));
-        window.addGameObject(&left);
-
-        Platform top;
-        top.setSize(sf::Vector2f(800, 10.f));
-        top.setFillColor(sf::Color(100, 0, 0));
-        top.setPosition(sf::Vector2f(0, 0));
-        window.addGameObject(&top);
-
-        Platform personal;
-        personal.setSize(sf::Vector2f(150.f, 40.f));
-        personal.setFillColor(sf::Color::Transparent);
-        personal.setPosition(sf::Vector2f(250.f, 600.f));
-        
-
-        Character character;
-        character.setPosition(10, 10);
-        character.setSpawnPoint(SpawnPoint(character.getPosition()));
-        character.setConnecting(1);
-        window.addPlayableObject(&character);
-        //Set up the list of occupied squares.
-        for (int i = 0; i < 780 / character.getSize().x; i++) {
-            for (int j = 0; j < 580 / character.getSize().y; j++) {
-                //Skip the first square (Character is occupying it)
-                if (!(i == 0 && j == 0)) {
-                    character.unoccupied.push_back(sf::Vector2f(i * character.getSize().x + 10, j * character.getSize().y + 10));
-                }
-            }
-        }
-
-        //Get initial apple position
-        srand(time(NULL));
-        int appleIndex = rand() % character.unoccupied.size();
-        int count = 0;
-        sf::Vector2f newPosition;
-        std::list<sf::Vector2f>::iterator it = character.unoccupied.begin();
-        for (sf::Vector2f i : character.unoccupied) {
-            if (count == appleIndex) {
-                newPosition = i;
-            }
-            it++;
-            count++;
-        }
-        //Change the apple's position to the generated one.
-        character.apple->setPosition(newPosition);
-        window.addGameObject(character.apple);
-        character.apple->setFillColor(sf::Color::Red);
-        character.apple->setSize(sf::Vector2f(CHAR_SPEED, CHAR_SPEED));
-        character.apple->setOutlineThickness(-1.f);
-        character.apple->setOutlineColor(sf::Color::Black);
+        //The board, its walls and where the view starts. The server plays on the same one. -arena picks the size.
+        Level level = Level::parseArena(argc, argv);
+        level.addTo(&world);
 
         //Add templates
-        window.addTemplate(bottom.makeTemplate());
-        window.addTemplate(character.makeTemplate());
-        window.addTemplate(std::shared_ptr<MovingPlatform>(new MovingPlatform));
+        world.addTemplate(std::shared_ptr<Platform>(new Platform));
+        world.addTemplate(std::shared_ptr<MovingPlatform>(new MovingPlatform));
 
 
         //END SETTING UP GAME OBJECTS
 
         //Set up timing variables
-        int64_t tic = 0;
         int64_t currentTic = 0;
         float scale = 1.0;
         float ticLength;
@@ -140,7 +100,9 @@ int main(int argc, char **argv) {
 
         //Set up necessary thread vairables
         std::mutex mutex;
-        bool upPressed = false;
+        //The direction the player last pressed, for CThread to send. -1 when there is nothing new.
+        std::atomic<int> input;
+        input = -1;
         bool busy = true;
         bool stopped = false;
         std::condition_variable cv;
@@ -152,41 +114,23 @@ int main(int argc, char **argv) {
 
         EventManager eventManager(&window, &globalTime);
 
+        //With -inproc the server runs in this process and every message stays in memory.
+        Transport transport(Transport::parseMode(argc, argv));
+        //Over TCP the server is another process, so nothing of it is built here.
+        Timeline serverTime(&globalTime, TIC);
+        EventManager serverManager(&globalTime);
+        Server* server = nullptr;
+        std::thread serverThread;
+        if (transport.getMode() == Transport::INPROC) {
+            server = new Server(&transport, &serverTime, &serverManager, level);
+            serverThread = std::thread(run_server, server);
+        }
 
-        //Start collision detection thread
-        CThread cthread(&upPressed, &window, &CTime, &stopped, &mutex, &cv, &busy, &eventManager);
+        //Start the thread that plays through the server and draws its board
+        CThread cthread(&input, &window, &level, &CTime, &stopped, &mutex, &cv, &busy, &eventManager, &transport);
         std::thread first(run_cthread, &cthread);
-        int lastLeft = 0;
-        int lastRight = 0;
-        int lastStop = 0;
-        bool leftPressed = false;
-        bool rightPressed = false;
-
-        std::string type("stop");
-        std::list<std::string> types;
-        types.push_back(type);
-        eventManager.registerEvent(types, new StopHandler());
-
-        type = "input";
-        types.clear();
-        types.push_back(type);
-        eventManager.registerEvent(types, new MovementHandler());
-
-        Event m;
-        m.order = 1;
-        m.time = FrameTime.convertGlobal(currentTic);
-        m.type = std::string("input");
-
-        Event::variant characterVariant;
-        characterVariant.m_Type = Event::variant::TYPE_GAMEOBJECT;
-        characterVariant.m_asGameObject = &character;
-        m.parameters.insert({ "character", characterVariant });
-
-        Event::variant directionVariant;
-        directionVariant.m_Type = Event::variant::TYPE_INT;
-        directionVariant.m_asInt = MovementHandler::DIRECTION::UP;
-        m.parameters.insert({ "direction", directionVariant });
-        int numInputs = 0;
+        RenderThread renderthread(&window, &stopped);
+        std::thread render(run_render, &renderthread);
 
         while (window.isOpen()) {
 
@@ -200,6 +144,13 @@ int main(int argc, char **argv) {
                     //Need to notify all so they can stop
                     cv.notify_all();
                     first.join();
+                    render.join();
+                    if (server != nullptr) {
+                        server->stop();
+                        serverThread.join();
+                        delete server;
+                        server = nullptr;
+                    }
                     window.setActive(true);
                     window.close();
 
@@ -209,38 +160,22 @@ int main(int argc, char **argv) {
                 }
 
                 if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::W || event.key.code == sf::Keyboard::Up)) {
-                    m.time = FrameTime.convertGlobal(currentTic + ++numInputs);
-                    directionVariant.m_asInt = MovementHandler::DIRECTION::UP;
-                    m.parameters.insert_or_assign( "direction", directionVariant );
-                    eventManager.raise(m);
+                    input = Arena::UP;
                 }
                 if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::A || event.key.code == sf::Keyboard::Left)) {
-                    m.time = FrameTime.convertGlobal(currentTic + ++numInputs);
-                    directionVariant.m_asInt = MovementHandler::DIRECTION::LEFT;
-                    m.parameters.insert_or_assign( "direction", directionVariant );
-                    eventManager.raise(m);
+                    input = Arena::LEFT;
                 }
                 if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::S || event.key.code == sf::Keyboard::Down)) {
-                    m.time = FrameTime.convertGlobal(currentTic + ++numInputs);
-                    directionVariant.m_asInt = MovementHandler::DIRECTION::DOWN;
-                    m.parameters.insert_or_assign("direction", directionVariant );
-                    eventManager.raise(m);
+                    input = Arena::DOWN;
                 }
                 if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::D || event.key.code == sf::Keyboard::Right)) {
-                    m.time = FrameTime.convertGlobal(currentTic + ++numInputs);
-                    directionVariant.m_asInt = MovementHandler::DIRECTION::RIGHT;
-                    m.parameters.insert_or_assign( "direction", directionVariant );
-                    eventManager.raise(m);
+                    input = Arena::RIGHT;
                 }
                 if (event.type == sf::Event::Resized)
                 {
                     window.handleResize(event);
                 }
             }
-            if (currentTic > tic) {
-                numInputs = 0;
-                tic = currentTic;
-            }
         }
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include "Arena.h"
+#include <algorithm>
+#include <cstdio>
+
+//Columns and rows moved by each DIRECTION.
+static const int moveX[] = { -1, 1, 0, 0 };
+static const int moveY[] = { 0, 0, -1, 1 };
+//Most bytes writeState() needs for the header, for a record without its body, and for a cell after it.
+#define STATE_HEADER_SIZE 32
+#define STATE_RECORD_SIZE 64
+#define STATE_CELL_SIZE 12
+
+Arena::Arena(const Level* level, unsigned int seed, WorkerPool* workers)
+    : board(level->makeBoard()), regions(board.getChunkRows()), random(seed), workers(workers) {
+    regionCells = board.getColumns() * CHUNK_SIZE;
+    for (Region& region : regions) {
+        region.random.seed(random());
+    }
+}
+
+int Arena::regionOf(int cell) const {
+    return cell / regionCells;
+}
+
+void Arena::addSnake(int id) {
+    if (indexOf.count(id) != 0) {
+        return;
+    }
+    indexOf.insert({ id, (int)snakes.size() });
+    snakes.emplace_back();
+    ArenaSnake& snake = snakes.back();
+    snake.id = id;
+    snake.direction = RIGHT;
+    snake.moved = RIGHT;
+    int cell = board.randomFree(&random);
+    snake.region = cell == -1 ? 0 : regionOf(cell);
+    regions[snake.region].snakes.push_back((int)snakes.size() - 1);
+    spawn(snake, cell);
+    //Keep enough apples around for everyone.
+    int apples = 0;
+    for (Region& region : regions) {
+        apples += (int)region.apples.size();
+    }
+    for (; apples < std::max(1, (int)snakes.size() / SNAKES_PER_APPLE) && board.freeCount() > 0; apples++) {
+        addApple();
+    }
+}
+
+void Arena::removeSnake(int id) {
+    auto found = indexOf.find(id);
+    if (found == indexOf.end()) {
+        return;
+    }
+    int index = found->second;
+    kill(snakes[index], -1);
+    indexOf.erase(found);
+    std::vector<int>& owned = regions[snakes[index].region].snakes;
+    owned.erase(std::find(owned.begin(), owned.end(), index));
+    //Fill the hole with the last snake.
+    int last = (int)snakes.size() - 1;
+    if (index != last) {
+        snakes[index] = std::move(snakes.back());
+        indexOf[snakes[index].id] = index;
+        std::vector<int>& moved = regions[snakes[index].region].snakes;
+        *std::find(moved.begin(), moved.end(), last) = index;
+    }
+    snakes.pop_back();
+}
+
+bool Arena::hasSnake(int id) {
+    return indexOf.count(id) != 0;
+}
+
+void Arena::steer(int id, int direction) {
+    auto found = indexOf.find(id);
+    if (found == indexOf.end() || direction < LEFT || direction > DOWN) {
+        return;
+    }
+    ArenaSnake& snake = snakes[found->second];
+    //LEFT and RIGHT, and UP and DOWN, only differ in the last bit.
+    if (direction != (snake.moved ^ 1)) {
+        snake.direction = direction;
+    }
+}
+
+void Arena::spawn(ArenaSnake& snake, int cell) {
+    if (cell == -1) {
+        return;
+    }
+    snake.head = cell;
+    snake.announced = false;
+    board.occupy(cell, OccupancyGrid::BODY);
+    //Cells of other regions may be changing under us.
+    for (int direction = LEFT; direction <= DOWN; direction++) {
+        int next = board.neighbor(cell, moveX[direction], moveY[direction]);
+        if (next != -1 && regionOf(next) == snake.region && board.contentAt(next) == OccupancyGrid::EMPTY) {
+            snake.direction = direction;
+            break;
+        }
+    }
+    snake.moved = snake.direction;
+}
+
+void Arena::leave(int cell, int r) {
+    if (r == -1 || regionOf(cell) == r) {
+        board.release(cell);
+    }
+    else {
+        regions[r].released.push_back(cell);
+    }
+}
+
+void Arena::kill(ArenaSnake& snake, int r) {
+    if (snake.head == -1) {
+        return;
+    }
+    leave(snake.head, r);
+    for (int i = 0; i < snake.body.size(); i++) {
+        leave(snake.body.at(i), r);
+    }
+    snake.body.clear();
+    snake.head = -1;
+    snake.deaths++;
+}
+
+void Arena::addApple() {
+    int cell = board.randomFree(&random);
+    if (cell != -1) {
+        board.occupy(cell, OccupancyGrid::APPLE);
+        regions[regionOf(cell)].apples.push_back(cell);
+    }
+}
+
+void Arena::addApple(int r) {
+    Region& region = regions[r];
+    int cell = board.randomFree(&region.random, r, r + 1);
+    if (cell != -1) {
+        board.occupy(cell, OccupancyGrid::APPLE);
+        region.apples.push_back(cell);
+    }
+}
+
+void Arena::move(ArenaSnake& snake, int next, int r) {
+    snake.moved = snake.direction;
+    OccupancyGrid::CONTENT content = board.contentAt(next);
+    //Our own tail moves off its cell this tic, so running into it is safe.
+    if (content == OccupancyGrid::BODY && snake.body.size() != 0 && next == snake.body.back()) {
+        content = OccupancyGrid::EMPTY;
+    }
+    if (content != OccupancyGrid::EMPTY && content != OccupancyGrid::APPLE) {
+        kill(snake, r);
+        return;
+    }
+    snake.body.pushFront(snake.head);
+    board.occupy(next, OccupancyGrid::BODY);
+    snake.head = next;
+    if (content == OccupancyGrid::APPLE) {
+        //The tail stays put, so the body is one longer. The apple comes back somewhere else in the region.
+        std::vector<int>& apples = regions[r].apples;
+        apples.erase(std::find(apples.begin(), apples.end(), next));
+        addApple(r);
+        return;
+    }
+    int tail = snake.body.popBack();
+    if (tail != next) {
+        leave(tail, r);
+    }
+}
+
+void Arena::runRegion(int r) {
+    Region& region = regions[r];
+    if (phase == MOVE) {
+        region.up.clear();
+        region.down.clear();
+        region.released.clear();
+        int kept = 0;
+        for (int index : region.snakes) {
+            ArenaSnake& snake = snakes[index];
+            if (snake.head == -1) {
+                spawn(snake, board.randomFree(&region.random, r, r + 1));
+            }
+            else {
+                int next = board.neighbor(snake.head, moveX[snake.direction], moveY[snake.direction]);
+                //Off the board is a wall, which any region can run into.
+                int to = next == -1 ? r : regionOf(next);
+                if (to != r) {
+                    (to < r ? region.up : region.down).push_back(index);
+                    continue;
+                }
+                move(snake, next, r);
+            }
+            region.snakes[kept++] = index;
+        }
+        region.snakes.resize(kept);
+        return;
+    }
+
+    //The snakes coming in only change cells of this region, like its own did.
+    for (int from : { r - 1, r + 1 }) {
+        if (from < 0 || from >= (int)regions.size()) {
+            continue;
+        }
+        for (int index : (from < r ? regions[from].down : regions[from].up)) {
+            ArenaSnake& snake = snakes[index];
+            snake.region = r;
+            move(snake, board.neighbor(snake.head, moveX[snake.direction], moveY[snake.direction]), r);
+            region.snakes.push_back(index);
+        }
+    }
+}
+
+void Arena::runRegionTask(void* arena, int r) {
+    ((Arena*)arena)->runRegion(r);
+}
+
+void Arena::runPhase(PHASE phase) {
+    this->phase = phase;
+    if (workers == nullptr) {
+        for (int r = 0; r < (int)regions.size(); r++) {
+            runRegion(r);
+        }
+        return;
+    }
+    //A board of one region is run on the calling thread, without waking anyone.
+    workers->run((int)regions.size(), runRegionTask, this);
+}
+
+void Arena::step() {
+    runPhase(MOVE);
+    runPhase(ARRIVE);
+    for (Region& region : regions) {
+        for (int cell : region.released) {
+            board.release(cell);
+        }
+    }
+    if (++steps % TRIM_STEPS == 0) {
+        board.trim();
+    }
+}
+
+int Arena::getScore(int id) {
+    auto found = indexOf.find(id);
+    if (found == indexOf.end() || snakes[found->second].head == -1) {
+        return 0;
+    }
+    return snakes[found->second].body.size() + 1;
+}
+
+int Arena::getBestScore() {
+    int best = 0;
+    for (ArenaSnake& snake : snakes) {
+        if (snake.head != -1) {
+            best = std::max(best, snake.body.size() + 1);
+        }
+    }
+    return best;
+}
+
+sf::Vector2f Arena::getHeadPosition(int id) {
+    auto found = indexOf.find(id);
+    if (found == indexOf.end() || snakes[found->second].head == -1) {
+        return sf::Vector2f(0, 0);
+    }
+    return board.positionOf(snakes[found->second].head);
+}
+
+int Arena::size() {
+    return (int)snakes.size();
+}
+
+int Arena::getRegionCount() {
+    return (int)regions.size();
+}
+
+OccupancyGrid* Arena::getBoard() {
+    return &board;
+}
+
+std::vector<ArenaSnake>* Arena::getSnakes() {
+    return &snakes;
+}
+
+size_t Arena::stateBound(bool full) {
+    size_t size = STATE_HEADER_SIZE + 2;
+    for (ArenaSnake& snake : snakes) {
+        size += STATE_RECORD_SIZE;
+        if (full || !snake.announced) {
+            size += (size_t)snake.body.size() * STATE_CELL_SIZE;
+        }
+    }
+    for (Region& region : regions) {
+        size += region.apples.size() * STATE_CELL_SIZE;
+    }
+    return size;
+}
+
+size_t Arena::writeState(char* buffer, bool full) {
+    char* end = buffer;
+    end += snprintf(end, STATE_HEADER_SIZE, "%c %lld ", full ? 'F' : 'D', (long long)steps);
+    for (ArenaSnake& snake : snakes) {
+        int length = snake.head == -1 ? 0 : snake.body.size() + 1;
+        end += snprintf(end, STATE_RECORD_SIZE, "%d %d %d %d", snake.id, snake.head, length, snake.moved);
+        if (full || !snake.announced) {
+            *end++ = ':';
+            for (int i = 0; i < snake.body.size(); i++) {
+                end += snprintf(end, STATE_CELL_SIZE, i == 0 ? "%d" : " %d", snake.body.at(i));
+            }
+            //Dead snakes have nothing to send until they spawn again.
+            snake.announced = snake.head != -1;
+        }
+        *end++ = ',';
+    }
+    *end++ = ';';
+    for (Region& region : regions) {
+        for (int cell : region.apples) {
+            end += snprintf(end, STATE_CELL_SIZE, "%d,", cell);
+        }
+    }
+    *end = '\0';
+    return end - buffer;
+}
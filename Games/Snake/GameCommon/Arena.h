@@ -0,0 +1,274 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "Level.h"
+#include "OccupancyGrid.h"
+#include "SnakeBody.h"
+#include "WorkerPool.h"
+
+//Apples on the board for each snake in it (at least one).
+#define SNAKES_PER_APPLE 4
+//Steps between giving back the memory of board chunks every snake has left.
+#define TRIM_STEPS 256
+//Tics between full boards on BOARD_PORT. Clients that join in between wait for the next one.
+#define BOARD_FULL_TICS 40
+
+/**
+* One snake in an Arena.
+*/
+struct ArenaSnake {
+    /**
+    * The player's ID.
+    */
+    int id;
+    /**
+    * Cell the head is in, -1 while dead.
+    */
+    int head = -1;
+    SnakeBody body;
+    /**
+    * Where the player last steered, and where the snake actually went last tic. Turning straight back is ignored.
+    */
+    int direction;
+    int moved;
+    /**
+    * Times the snake has died.
+    */
+    int deaths = 0;
+    /**
+    * The region that moves the snake. The one its head is in, or where it last was while dead.
+    */
+    int region = 0;
+    /**
+    * False until writeState() has sent the whole snake since it last spawned.
+    */
+    bool announced = false;
+};
+
+/**
+* Every snake on one server board, stepped together once a tic. This is GravityHandler and SpawnHandler for many
+* players at once, kept as plain arrays instead of Characters and events: moving a snake is one board lookup, and
+* bodies only allocate when one grows past its longest yet. Snakes that hit a wall, themselves or each other die
+* and come back on a random free cell the next tic.
+*
+* The board is split into regions, one per row of board chunks, and each region moves the snakes whose heads are
+* in it. Regions only ever change their own cells, so step() hands them out to worker threads:
+* 1. Every region moves its snakes in order, so a snake can move into a cell that one earlier in its region has
+*    just left, but not one that a later snake is about to leave. A snake whose next cell is in the region above or
+*    below is handed over to that region instead, and cells of other regions that a snake leaves (its tail, or its
+*    whole body when it dies) are kept as messages.
+* 2. Every region moves the snakes handed to it, from the region above first, and takes them on.
+* 3. The cells in the messages are freed. Until then they still count as body, for everyone.
+* Each region has its own apples and its own random numbers, and respawns its dead snakes in its own rows. None of
+* this depends on which thread runs what, so for a seed and a board the result is the same with any number of
+* threads, including none, and a run can be replayed.
+* Not thread safe, the server locks around it.
+*/
+class Arena {
+public:
+    /**
+    * Directions a snake can be steered in. Same values as MovementHandler::DIRECTION.
+    */
+    enum DIRECTION {
+        LEFT,
+        RIGHT,
+        UP,
+        DOWN
+    };
+
+private:
+    /**
+    * One row of board chunks, and what it owns.
+    */
+    struct Region {
+        /**
+        * The snakes it moves, as indices into snakes, in the order they move.
+        */
+        std::vector<int> snakes;
+        /**
+        * Snakes about to move into the region above or below, for that region to move.
+        */
+        std::vector<int> up;
+        std::vector<int> down;
+        /**
+        * Cells in other regions left by its snakes this step.
+        */
+        std::vector<int> released;
+        /**
+        * Cells in the region with an apple in them.
+        */
+        std::vector<int> apples;
+        std::mt19937 random;
+    };
+
+    /**
+    * Parts of a step run by every region.
+    */
+    enum PHASE {
+        MOVE,
+        ARRIVE
+    };
+
+    OccupancyGrid board;
+
+    std::vector<ArenaSnake> snakes;
+
+    /**
+    * Where each player's snake is in snakes.
+    */
+    std::unordered_map<int, int> indexOf;
+
+    std::vector<Region> regions;
+
+    /**
+    * Cells in a region: CHUNK_SIZE rows of the board.
+    */
+    int regionCells;
+
+    /**
+    * Picks where snakes and apples added between steps go, and seeds the regions.
+    */
+    std::mt19937 random;
+
+    /**
+    * The phase being run, and the threads helping step() run it for every region, if any.
+    */
+    PHASE phase = MOVE;
+    WorkerPool* workers;
+
+    /**
+    * Steps taken so far.
+    */
+    int64_t steps = 0;
+
+    /**
+    * Return the region a cell is in.
+    */
+    int regionOf(int cell) const;
+
+    /**
+    * Put a dead snake in a free cell of its region, facing a free neighbor in the region if it has one. Does
+    * nothing if cell is -1.
+    */
+    void spawn(ArenaSnake& snake, int cell);
+
+    /**
+    * Free a cell left by a snake in region r: now if it is in r, or at the end of the step if it isn't.
+    * r -1 frees it now wherever it is, for between steps.
+    */
+    void leave(int cell, int r);
+
+    /**
+    * Free every cell of a snake in region r (see leave()) and mark it dead.
+    */
+    void kill(ArenaSnake& snake, int r);
+
+    /**
+    * Put an apple on a random free cell of the board, or of region r, if there is one.
+    */
+    void addApple();
+    void addApple(int r);
+
+    /**
+    * Move a snake of region r into next, a cell in r.
+    */
+    void move(ArenaSnake& snake, int next, int r);
+
+    /**
+    * Run one phase of the step for region r.
+    */
+    void runRegion(int r);
+
+    /**
+    * WorkerPool task running the current phase for region r of the arena.
+    */
+    static void runRegionTask(void* arena, int r);
+
+    /**
+    * Run a phase for every region, on the workers and the calling thread, and return when all are done.
+    */
+    void runPhase(PHASE phase);
+
+public:
+    /**
+    * Create an empty arena with a board made from a level.
+    * @param workers threads to help step() with, shared with whoever else uses them between steps. nullptr steps
+    * every region on the calling thread, and so does a board with one region whatever this is.
+    */
+    Arena(const Level* level, unsigned int seed, WorkerPool* workers = nullptr);
+
+    /**
+    * Add a snake for a player and spawn it. Does nothing if the player already has one.
+    */
+    void addSnake(int id);
+
+    /**
+    * Take a player's snake off the board.
+    */
+    void removeSnake(int id);
+
+    bool hasSnake(int id);
+
+    /**
+    * Steer a player's snake. Takes effect on the next step(). Turning straight back is ignored.
+    */
+    void steer(int id, int direction);
+
+    /**
+    * Move every snake one cell, eat apples and kill snakes that ran into something.
+    */
+    void step();
+
+    /**
+    * Return a player's score (body length plus the head), or 0 if it has no snake or is dead.
+    */
+    int getScore(int id);
+
+    /**
+    * Return the highest score on the board.
+    */
+    int getBestScore();
+
+    /**
+    * Return the board position of a player's head, or (0, 0) if it has no snake or is dead.
+    */
+    sf::Vector2f getHeadPosition(int id);
+
+    /**
+    * Return the number of snakes.
+    */
+    int size();
+
+    /**
+    * Return the number of regions the board is split into.
+    */
+    int getRegionCount();
+
+    OccupancyGrid* getBoard();
+
+    std::vector<ArenaSnake>* getSnakes();
+
+    /**
+    * Return the most bytes writeState() can write, with its terminating null, if it is called now.
+    */
+    size_t stateBound(bool full);
+
+    /**
+    * Write the board into buffer, which must hold stateBound(full) bytes, for clients to follow with a BoardView.
+    * "F <step> " starts a full board and "D <step> " the changes made by the step() that got to <step>. Then comes
+    * a record for every snake, then ";" and "cell," for every apple. Cells are numbered as in OccupancyGrid.
+    * A record is "id head length direction," (a dead snake's head is -1 and its length 0), which a client that has
+    * the snake already moves it by: the old head joins the body, and the tail goes unless the snake got longer.
+    * The first record after a snake spawns, and every record of a full board, sends the whole snake instead:
+    * "id head length direction:cell cell ...," with the body front first. Apples are always sent in full.
+    * @return the number of bytes written, without the null.
+    */
+    size_t writeState(char* buffer, bool full);
+};
+
+#endif
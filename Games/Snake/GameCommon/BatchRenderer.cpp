@@ -0,0 +1,114 @@
+#include "BatchRenderer.h"
+
+BatchRenderer::BatchRenderer() : vertices(sf::Triangles) {
+}
+
+bool BatchRenderer::canBatch(const sf::RectangleShape* shape) {
+    return shape != nullptr && shape->getTexture() == nullptr;
+}
+
+/**
+* Write the two triangles of a quad, in local coordinates, starting at vertex.
+*/
+static void writeQuad(sf::Vertex* vertex, const sf::Transform& transform, sf::FloatRect rect, sf::Color color) {
+    sf::Vector2f topLeft = transform.transformPoint(rect.left, rect.top);
+    sf::Vector2f topRight = transform.transformPoint(rect.left + rect.width, rect.top);
+    sf::Vector2f bottomRight = transform.transformPoint(rect.left + rect.width, rect.top + rect.height);
+    sf::Vector2f bottomLeft = transform.transformPoint(rect.left, rect.top + rect.height);
+    vertex[0] = sf::Vertex(topLeft, color);
+    vertex[1] = sf::Vertex(topRight, color);
+    vertex[2] = sf::Vertex(bottomRight, color);
+    vertex[3] = sf::Vertex(topLeft, color);
+    vertex[4] = sf::Vertex(bottomRight, color);
+    vertex[5] = sf::Vertex(bottomLeft, color);
+}
+
+void BatchRenderer::write(const sf::RectangleShape* shape, size_t first) {
+    sf::Vector2f size = shape->getSize();
+    float thickness = shape->getOutlineThickness();
+    //SFML puts positive outlines outside the rectangle and negative ones inside it.
+    sf::FloatRect inside(0, 0, size.x, size.y);
+    sf::FloatRect outside = inside;
+    if (thickness > 0) {
+        outside = sf::FloatRect(-thickness, -thickness, size.x + 2 * thickness, size.y + 2 * thickness);
+    }
+    else if (thickness < 0) {
+        inside = sf::FloatRect(-thickness, -thickness, size.x + 2 * thickness, size.y + 2 * thickness);
+    }
+    const sf::Transform& transform = shape->getTransform();
+    //The outline quad is drawn first and the fill covers all of it but the border. No outline leaves it empty.
+    writeQuad(&vertices[first], transform, thickness != 0 ? outside : sf::FloatRect(), shape->getOutlineColor());
+    writeQuad(&vertices[first + 6], transform, inside, shape->getFillColor());
+}
+
+void BatchRenderer::add(const sf::RectangleShape* shape) {
+    auto found = slots.find(shape);
+    if (found != slots.end()) {
+        write(shape, found->second);
+        return;
+    }
+    size_t first = vertices.getVertexCount();
+    vertices.resize(first + BATCH_RECT_VERTICES);
+    slots.insert({ shape, first });
+    owners.push_back(shape);
+    write(shape, first);
+}
+
+void BatchRenderer::append(const sf::RectangleShape& shape) {
+    size_t first = vertices.getVertexCount();
+    vertices.resize(first + BATCH_RECT_VERTICES);
+    owners.push_back(nullptr);
+    write(&shape, first);
+}
+
+void BatchRenderer::update(const sf::RectangleShape* shape) {
+    auto found = slots.find(shape);
+    if (found != slots.end()) {
+        write(shape, found->second);
+    }
+}
+
+void BatchRenderer::remove(const sf::RectangleShape* shape) {
+    auto found = slots.find(shape);
+    if (found == slots.end()) {
+        return;
+    }
+    size_t first = found->second;
+    size_t last = vertices.getVertexCount() - BATCH_RECT_VERTICES;
+    slots.erase(found);
+    if (first != last) {
+        for (size_t i = 0; i < BATCH_RECT_VERTICES; i++) {
+            vertices[first + i] = vertices[last + i];
+        }
+        const sf::RectangleShape* moved = owners.back();
+        owners[first / BATCH_RECT_VERTICES] = moved;
+        if (moved != nullptr) {
+            slots[moved] = first;
+        }
+    }
+    owners.pop_back();
+    vertices.resize(last);
+}
+
+void BatchRenderer::appendTo(std::vector<sf::Vertex>* out) {
+    size_t count = vertices.getVertexCount();
+    if (count != 0) {
+        out->insert(out->end(), &vertices[0], &vertices[0] + count);
+    }
+}
+
+void BatchRenderer::clear() {
+    vertices.clear();
+    slots.clear();
+    owners.clear();
+}
+
+size_t BatchRenderer::size() {
+    return slots.size();
+}
+
+void BatchRenderer::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (vertices.getVertexCount() != 0) {
+        target.draw(vertices, states);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <unordered_map>
+#include <vector>
+
+//Vertices per rectangle: two triangles for the outline, two for the fill.
+#define BATCH_RECT_VERTICES 12
+
+/**
+* Draws any number of solid color rectangles with one draw call. Each rectangle added gets a fixed slot of vertices
+* in one sf::VertexArray, so moving one only rewrites its own slot instead of rebuilding the whole array.
+* Shapes with a texture can't be batched and have to be drawn on their own.
+* The batch copies the shape's geometry and colors when it is added or updated, so a shape that moves or changes
+* color has to be passed to update() before the next draw. Not thread safe, GameWindow locks around it.
+*/
+class BatchRenderer : public sf::Drawable {
+private:
+    sf::VertexArray vertices;
+
+    /**
+    * The first vertex of each rectangle's slot.
+    */
+    std::unordered_map<const sf::RectangleShape*, size_t> slots;
+
+    /**
+    * The shape in each slot, in slot order, so remove() can move the last one into the hole.
+    * nullptr for rectangles added with append().
+    */
+    std::vector<const sf::RectangleShape*> owners;
+
+    /**
+    * Write a shape's vertices into the slot starting at first.
+    */
+    void write(const sf::RectangleShape* shape, size_t first);
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+public:
+    BatchRenderer();
+
+    /**
+    * Return true if the shape can go in a batch (it has no texture).
+    */
+    static bool canBatch(const sf::RectangleShape* shape);
+
+    /**
+    * Add a rectangle to the batch. Adding one that is already in the batch updates it.
+    */
+    void add(const sf::RectangleShape* shape);
+
+    /**
+    * Add a copy of a rectangle as it is now, without remembering the shape. For things drawn once, so the same
+    * shape can be moved and appended many times in one frame.
+    */
+    void append(const sf::RectangleShape& shape);
+
+    /**
+    * Copy the shape's current position, size and colors into the batch. Does nothing if the shape isn't in it.
+    */
+    void update(const sf::RectangleShape* shape);
+
+    /**
+    * Take a rectangle out of the batch. The last rectangle is moved into its slot, so this doesn't shift the rest.
+    * Does nothing if the shape isn't in it.
+    */
+    void remove(const sf::RectangleShape* shape);
+
+    /**
+    * Append a copy of every vertex in the batch to out, for drawing somewhere else.
+    */
+    void appendTo(std::vector<sf::Vertex>* out);
+
+    /**
+    * Remove every rectangle. Keeps the vertex memory for the next frame.
+    */
+    void clear();
+
+    /**
+    * Return the number of rectangles in the batch.
+    */
+    size_t size();
+};
+
+#endif
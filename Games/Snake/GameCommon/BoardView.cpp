@@ -0,0 +1,167 @@
+#include "BoardView.h"
+#include <cstdlib>
+
+/**
+* Read a number and move text past it.
+* @return false if there wasn't one.
+*/
+static bool readNumber(const char** text, long long* value) {
+    char* end;
+    *value = strtoll(*text, &end, 10);
+    if (end == *text) {
+        return false;
+    }
+    *text = end;
+    return true;
+}
+
+BoardView::BoardView(const Level* level) : board(level->makeBoard()) {
+    this->level = level;
+}
+
+void BoardView::clear(BoardSnake& snake) {
+    if (snake.head != -1) {
+        left.push_back(snake.head);
+    }
+    for (int i = 0; i < snake.body.size(); i++) {
+        left.push_back(snake.body.at(i));
+    }
+    snake.body.clear();
+    snake.head = -1;
+    snake.length = 0;
+}
+
+bool BoardView::apply(const char* state) {
+    char type = state[0];
+    const char* next = state + 1;
+    long long number;
+    if ((type != 'F' && type != 'D') || !readNumber(&next, &number)) {
+        return false;
+    }
+    //Changes only make sense on top of the step before them.
+    if (type == 'D' && (!synced || number != step + 1)) {
+        synced = false;
+        return false;
+    }
+    if (type == 'F') {
+        level->reset(&board);
+    }
+    step = number;
+    synced = true;
+
+    long long values[4];
+    while (true) {
+        int read = 0;
+        while (read < 4 && readNumber(&next, &values[read])) {
+            read++;
+        }
+        if (read < 4) {
+            break;
+        }
+        BoardSnake& snake = snakes[(int)values[0]];
+        int head = (int)values[1];
+        if (*next == ':') {
+            //The whole snake, front first.
+            next++;
+            clear(snake);
+            cells.clear();
+            long long cell;
+            while (*next != ',' && readNumber(&next, &cell)) {
+                cells.push_back((int)cell);
+            }
+            for (int i = (int)cells.size() - 1; i >= 0; i--) {
+                snake.body.pushFront(cells[i]);
+                entered.push_back(cells[i]);
+            }
+            snake.head = head;
+        }
+        else if (head == -1) {
+            clear(snake);
+        }
+        else {
+            //The old head becomes the front of the body, and the tail goes unless the snake got longer.
+            if (snake.head != -1) {
+                snake.body.pushFront(snake.head);
+            }
+            snake.head = head;
+            while (snake.body.size() > 0 && snake.body.size() + 1 > values[2]) {
+                left.push_back(snake.body.popBack());
+            }
+        }
+        if (head != -1) {
+            entered.push_back(head);
+        }
+        snake.length = head == -1 ? 0 : (int)values[2];
+        snake.direction = (int)values[3];
+        snake.seen = number;
+        if (*next == ',') {
+            next++;
+        }
+    }
+
+    //Snakes that weren't in this board have left.
+    for (auto it = snakes.begin(); it != snakes.end();) {
+        if (it->second.seen != number) {
+            clear(it->second);
+            it = snakes.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+
+    for (int cell : apples) {
+        left.push_back(cell);
+    }
+    apples.clear();
+    if (*next == ';') {
+        next++;
+        long long cell;
+        while (readNumber(&next, &cell) && *next == ',') {
+            apples.push_back((int)cell);
+            next++;
+        }
+    }
+
+    for (int cell : left) {
+        board.release(cell);
+    }
+    for (int cell : entered) {
+        board.occupy(cell, OccupancyGrid::BODY);
+    }
+    for (int cell : apples) {
+        board.occupy(cell, OccupancyGrid::APPLE);
+    }
+    left.clear();
+    entered.clear();
+    return true;
+}
+
+void BoardView::restart() {
+    synced = false;
+}
+
+bool BoardView::isSynced() {
+    return synced;
+}
+
+int64_t BoardView::getStep() {
+    return step;
+}
+
+const OccupancyGrid* BoardView::getBoard() {
+    return &board;
+}
+
+const BoardSnake* BoardView::getSnake(int id) {
+    auto found = snakes.find(id);
+    return found == snakes.end() ? nullptr : &found->second;
+}
+
+const std::unordered_map<int, BoardSnake>* BoardView::getSnakes() {
+    return &snakes;
+}
+
+const std::vector<int>* BoardView::getApples() {
+    return &apples;
+}
@@ -0,0 +1,123 @@
+#ifndef BOARDVIEW_H
+#define BOARDVIEW_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Level.h"
+#include "OccupancyGrid.h"
+#include "SnakeBody.h"
+
+/**
+* One snake as a client sees it on the published board.
+*/
+struct BoardSnake {
+    /**
+    * Cell the head is in, -1 while dead.
+    */
+    int head = -1;
+    /**
+    * Body length plus the head, 0 while dead.
+    */
+    int length = 0;
+    /**
+    * Where the snake went last tic, an Arena::DIRECTION.
+    */
+    int direction = 0;
+    SnakeBody body;
+    /**
+    * Step of the last board the snake was in. Snakes missing from a board have left.
+    */
+    int64_t seen = -1;
+};
+
+/**
+* A server arena rebuilt on the client from what Arena::writeState() publishes on BOARD_PORT: every snake with its
+* body, and the apples, on an OccupancyGrid made from the same Level. A view starts from the first full board it
+* gets and then moves every snake by the changes in each step after it, so a client that joins late has everyone's
+* whole body by the next full board. If a step goes missing the view waits for the next full board again.
+* Applying a step only touches the cells that changed, and doesn't allocate once the bodies have grown.
+* Not thread safe.
+*/
+class BoardView {
+private:
+    const Level* level;
+
+    OccupancyGrid board;
+
+    std::unordered_map<int, BoardSnake> snakes;
+
+    std::vector<int> apples;
+
+    /**
+    * Step of the last board applied, and whether every step since a full board has been.
+    */
+    int64_t step = -1;
+    bool synced = false;
+
+    /**
+    * Cells left and entered in the step being applied. Everything is left before anything is entered, so a snake
+    * can move into a cell another one left in the same step, whatever order their records come in.
+    */
+    std::vector<int> left;
+    std::vector<int> entered;
+
+    /**
+    * Body of the snake being read, front first.
+    */
+    std::vector<int> cells;
+
+    /**
+    * Leave every cell of a snake and mark it dead.
+    */
+    void clear(BoardSnake& snake);
+
+public:
+    /**
+    * Create a view of an arena played on level. Empty until the first full board.
+    */
+    BoardView(const Level* level);
+
+    /**
+    * Apply a board from Arena::writeState(), without the room it was published for.
+    * @return false if it was skipped: a step of changes before the first full board, or after a missing step.
+    */
+    bool apply(const char* state);
+
+    /**
+    * Wait for the next full board before applying changes again. For when the boards come from a new room.
+    */
+    void restart();
+
+    /**
+    * Return true if the view is up to date with the last board applied.
+    */
+    bool isSynced();
+
+    /**
+    * Return the step of the last board applied, or -1 if there hasn't been one.
+    */
+    int64_t getStep();
+
+    /**
+    * Return the board, with every body as BODY and every apple as APPLE.
+    */
+    const OccupancyGrid* getBoard();
+
+    /**
+    * Return a player's snake, or nullptr if it isn't on the board.
+    */
+    const BoardSnake* getSnake(int id);
+
+    /**
+    * Return every snake on the board, by player ID.
+    */
+    const std::unordered_map<int, BoardSnake>* getSnakes();
+
+    /**
+    * Return the cells with an apple in them.
+    */
+    const std::vector<int>* getApples();
+};
+
+#endif
@@ -3,6 +3,8 @@
 #include "GameObject.h"
 #include "SpawnPoint.h"
 #include "MovingPlatform.h"
+#include "OccupancyGrid.h"
+#include "SnakeBody.h"
 #include <SFML/OpenGL.hpp>
 #include <SFML/Graphics.hpp>
 #include <mutex>
@@ -11,6 +13,8 @@
 #define GRAV_SPEED 160
 #define CHARACTER 1
 
+class Level;
+
 /**
 * Class for Character objects, or the shape that is controlled by the player.
 * A character has speed, which is the amount of movement the character moves right or left per frame.
@@ -81,9 +85,20 @@ private:
 
 public:
 
-    std::list<Character*> trail;
+    /**
+    * The segments behind the head, as cells of board.
+    */
+    SnakeBody body;
+
+    /**
+    * The board the character plays on. Owned by whoever set up the game.
+    */
+    OccupancyGrid* board = nullptr;
 
-    std::list<sf::Vector2f> unoccupied;
+    /**
+    * The level board was made from, to reset it to on respawn.
+    */
+    const Level* level = nullptr;
 
     MovingPlatform* apple;
 
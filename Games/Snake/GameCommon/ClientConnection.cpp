@@ -0,0 +1,261 @@
+#include "ClientConnection.h"
+#include <cstring>
+
+/**
+* Skip the "<room> " a published message starts with.
+*/
+static const char* skipRoom(const char* message) {
+    const char* space = strchr(message, ' ');
+    return space == nullptr ? message : space + 1;
+}
+
+ClientConnection::ClientConnection(Transport* transport) {
+    this->transport = transport;
+}
+
+bool ClientConnection::waitFor(zmq::socket_t& socket, int timeout) {
+    zmq::pollitem_t items[] = { { socket.handle(), 0, ZMQ_POLLIN, 0 } };
+    zmq::poll(items, 1, std::chrono::milliseconds(timeout));
+    return (items[0].revents & ZMQ_POLLIN) != 0;
+}
+
+bool ClientConnection::join(int timeout) {
+    //Start with fresh sockets. A request socket that never got its reply can't send again.
+    reqSocket = zmq::socket_t(*transport->getContext(), zmq::socket_type::req);
+    subSocket = zmq::socket_t(*transport->getContext(), zmq::socket_type::sub);
+    reqSocket.set(zmq::sockopt::linger, 0);
+    subSocket.set(zmq::sockopt::linger, 0);
+    leaderboardSocket = zmq::socket_t();
+    boardSocket = zmq::socket_t();
+    leaders.clear();
+    leadersVersion = 0;
+    id = -1;
+    port = -1;
+    room = -1;
+
+    //Connect and get your own port.
+    reqSocket.connect(transport->endpoint(HANDSHAKE_PORT));
+
+    //Send the request to the server.
+    zmq::message_t initRequest;
+    if (token != 0 && budget > 0) {
+        transport->getPool()->format(&initRequest, "Resume %llu %d", token, budget);
+    }
+    else if (token != 0) {
+        transport->getPool()->format(&initRequest, "Resume %llu", token);
+    }
+    else if (requestedRoom >= 0 && budget > 0) {
+        transport->getPool()->format(&initRequest, "Join %d %d", requestedRoom, budget);
+    }
+    else if (requestedRoom >= 0) {
+        transport->getPool()->format(&initRequest, "Join %d", requestedRoom);
+    }
+    else if (budget > 0) {
+        transport->getPool()->format(&initRequest, "Connect %d", budget);
+    }
+    else {
+        transport->getPool()->format(&initRequest, "Connect");
+    }
+    reqSocket.send(initRequest, zmq::send_flags::none);
+
+    //Receive the reply from the server, should contain our port and ID
+    if (!waitFor(reqSocket, timeout)) {
+        return false;
+    }
+    zmq::message_t initReply;
+    zmq::recv_result_t r = reqSocket.recv(initReply, zmq::recv_flags::none);
+    int initId = -1;
+    int initPort = -1;
+    unsigned long long initToken = 0;
+    int initScore = 0;
+    int initRoom = 0;
+    int matches = sscanf_s((char*)initReply.data(), "%d %d %llu %d %d", &initId, &initPort, &initToken, &initScore, &initRoom);
+    if (matches != 5) {
+        return false;
+    }
+    //The server gives back the same token if it still had our session.
+    resumed = token != 0 && initToken == token;
+    token = initToken;
+    serverScore = initScore;
+
+    //Disconnect from main server process.
+    reqSocket.disconnect(transport->endpoint(HANDSHAKE_PORT));
+    //Bind to your unique port provided by the server.
+    reqSocket.bind(transport->endpoint(initPort));
+    //Conflate messages to avoid getting behind.
+    subSocket.set(zmq::sockopt::conflate, true);
+    //Only our room. The publisher filters, so other rooms never reach us and can't push ours out of the queue.
+    roomPrefix = std::to_string(initRoom) + " ";
+    subSocket.connect(transport->endpoint(PUB_PORT));
+    subSocket.set(zmq::sockopt::subscribe, roomPrefix);
+    //Every change matters here, so no conflating.
+    if (followLeaderboard) {
+        leaderboardSocket = zmq::socket_t(*transport->getContext(), zmq::socket_type::sub);
+        leaderboardSocket.set(zmq::sockopt::linger, 0);
+        leaderboardSocket.connect(transport->endpoint(LEADERBOARD_PORT));
+        leaderboardSocket.set(zmq::sockopt::subscribe, roomPrefix);
+    }
+    //No conflating the board either: every step of changes builds on the one before.
+    if (boardView != nullptr) {
+        boardView->restart();
+        boardSocket = zmq::socket_t(*transport->getContext(), zmq::socket_type::sub);
+        boardSocket.set(zmq::sockopt::linger, 0);
+        boardSocket.connect(transport->endpoint(BOARD_PORT));
+        boardSocket.set(zmq::sockopt::subscribe, roomPrefix);
+    }
+
+    id = initId;
+    port = initPort;
+    room = initRoom;
+    return true;
+}
+
+void ClientConnection::sendInput(int direction) {
+    zmq::message_t request;
+    transport->getPool()->format(&request, "%d", direction);
+    reqSocket.send(request, zmq::send_flags::none);
+}
+
+bool ClientConnection::receiveReply(std::string* reply, int timeout) {
+    if (!waitFor(reqSocket, timeout)) {
+        return false;
+    }
+    zmq::message_t message;
+    zmq::recv_result_t r = reqSocket.recv(message, zmq::recv_flags::none);
+    *reply = (char*)message.data();
+
+    //Everyone ages a reply. The ones in this reply start over.
+    lastRecords = 0;
+    for (auto& [id, player] : players) {
+        player.age++;
+    }
+    while (message.more()) {
+        r = reqSocket.recv(message, zmq::recv_flags::none);
+        readPlayers((char*)message.data());
+    }
+    for (auto it = players.begin(); it != players.end();) {
+        if (it->second.age > PLAYER_TIMEOUT) {
+            it = players.erase(it);
+        }
+        else {
+            it++;
+        }
+    }
+    return true;
+}
+
+void ClientConnection::readPlayers(const char* records) {
+    int pos = 0;
+    int id;
+    PlayerState player;
+    player.age = 0;
+    //pos stays 0 if the record wasn't finished with a comma.
+    while (sscanf_s(records, "%d %f %f %d,%n", &id, &player.x, &player.y, &player.score, &pos) == 4 && pos > 0) {
+        players.insert_or_assign(id, player);
+        lastRecords++;
+        records += pos;
+        pos = 0;
+    }
+}
+
+bool ClientConnection::receiveUpdate(std::string* update, int timeout) {
+    if (!waitFor(subSocket, timeout)) {
+        return false;
+    }
+    zmq::message_t message;
+    zmq::recv_result_t r = subSocket.recv(message, zmq::recv_flags::none);
+    *update = skipRoom((char*)message.data());
+    return true;
+}
+
+void ClientConnection::setFollowLeaderboard(bool follow) {
+    followLeaderboard = follow;
+}
+
+bool ClientConnection::receiveLeaderboard() {
+    if (!leaderboardSocket) {
+        return false;
+    }
+    bool changed = false;
+    zmq::message_t message;
+    while (leaderboardSocket.recv(message, zmq::recv_flags::dontwait)) {
+        changed |= Leaderboard::applyUpdate(skipRoom((char*)message.data()), &leaders, &leadersVersion);
+    }
+    return changed;
+}
+
+const std::vector<LeaderboardEntry>* ClientConnection::getLeaders() {
+    return &leaders;
+}
+
+void ClientConnection::setBoardView(BoardView* view) {
+    boardView = view;
+}
+
+bool ClientConnection::receiveBoard() {
+    if (!boardSocket) {
+        return false;
+    }
+    bool changed = false;
+    zmq::message_t message;
+    while (boardSocket.recv(message, zmq::recv_flags::dontwait)) {
+        changed |= boardView->apply(skipRoom((char*)message.data()));
+    }
+    return changed;
+}
+
+void ClientConnection::leave(int timeout) {
+    zmq::message_t request;
+    transport->getPool()->format(&request, "Leave");
+    reqSocket.send(request, zmq::send_flags::none);
+    std::string reply;
+    receiveReply(&reply, timeout);
+    id = -1;
+    port = -1;
+    room = -1;
+    token = 0;
+}
+
+void ClientConnection::setBudget(int budget) {
+    this->budget = budget;
+}
+
+void ClientConnection::setRoom(int room) {
+    requestedRoom = room;
+}
+
+int ClientConnection::getRoom() {
+    return room;
+}
+
+std::map<int, PlayerState>* ClientConnection::getPlayers() {
+    return &players;
+}
+
+int ClientConnection::getLastRecords() {
+    return lastRecords;
+}
+
+void ClientConnection::forget() {
+    token = 0;
+}
+
+bool ClientConnection::wasResumed() {
+    return resumed;
+}
+
+int ClientConnection::getServerScore() {
+    return serverScore;
+}
+
+void* ClientConnection::getReplyHandle() {
+    return reqSocket.handle();
+}
+
+int ClientConnection::getID() {
+    return id;
+}
+
+int ClientConnection::getPort() {
+    return port;
+}
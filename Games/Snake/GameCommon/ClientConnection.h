@@ -0,0 +1,269 @@
+#ifndef CLIENTCONNECTION_H
+#define CLIENTCONNECTION_H
+
+#include <zmq.hpp>
+#include <string>
+#include <map>
+#include <vector>
+#include "BoardView.h"
+#include "Leaderboard.h"
+#include "Transport.h"
+
+//Replies a player can go without an update before we assume it has left.
+#define PLAYER_TIMEOUT 400
+
+/**
+* What we last heard about another player.
+*/
+struct PlayerState {
+    float x;
+    float y;
+    int score;
+    /**
+    * Replies since this player was last updated.
+    */
+    int age;
+};
+
+/**
+* The client side of the game protocol.
+* join() asks the handshake port for an ID, a personal port and a room, binds the request socket to that port
+* and subscribes to the publisher for that room only. The server also hands out a token, and joining again with it resumes the
+* same session (same ID and port) instead of starting over. After that the client sends the direction it steers its
+* snake in once per tic with sendInput() and waits for the reply with receiveReply(). The snake lives in the room's
+* arena on the server, which decides where it goes and what it scores, so a client sees it (and everyone else) by
+* following the room's board with setBoardView(). Replies can carry a second frame with the other players the server
+* thinks matter most to us, as many as fit in our budget. Those are merged into getPlayers().
+* A client can also follow the leaderboard, which the server only sends when it changes.
+* leave() tells the server we are disconnecting.
+* Used by the windowed client (CThread) and by headless bots.
+*/
+class ClientConnection {
+private:
+    /**
+    * The transport sockets are created from.
+    */
+    Transport* transport;
+
+    /**
+    * Request socket. Talks to the handshake port first and then to our RepThread on the server.
+    */
+    zmq::socket_t reqSocket;
+
+    /**
+    * Subscriber socket for the publisher.
+    */
+    zmq::socket_t subSocket;
+
+    /**
+    * Subscriber socket for leaderboard changes. Only connected if we follow the leaderboard.
+    */
+    zmq::socket_t leaderboardSocket;
+
+    /**
+    * True if join() should subscribe to the leaderboard.
+    */
+    bool followLeaderboard = false;
+
+    /**
+    * Subscriber socket for the room's board, and the view it is applied to. Only connected if there is a view.
+    */
+    zmq::socket_t boardSocket;
+    BoardView* boardView = nullptr;
+
+    /**
+    * The leaderboard as far as we have heard, best first, and the version it is at.
+    */
+    std::vector<LeaderboardEntry> leaders;
+    int64_t leadersVersion = 0;
+
+    /**
+    * The ID handed out by the server. -1 if not joined.
+    */
+    int id = -1;
+
+    /**
+    * Our personal port. -1 if not joined.
+    */
+    int port = -1;
+
+    /**
+    * Token for resuming our session. 0 if we have never joined.
+    */
+    unsigned long long token = 0;
+
+    /**
+    * The room we asked for, -1 to let the server pick, and the room we are in. The server only tells us about
+    * players in our room.
+    */
+    int requestedRoom = -1;
+    int room = -1;
+
+    /**
+    * "<room> ", what everything the server publishes for our room starts with.
+    */
+    std::string roomPrefix;
+
+    /**
+    * True if the last join() got our old session back.
+    */
+    bool resumed = false;
+
+    /**
+    * The score the server had for us when we last joined.
+    */
+    int serverScore = 0;
+
+    /**
+    * Bytes of other players we ask for per tic. 0 lets the server decide.
+    */
+    int budget = 0;
+
+    /**
+    * Every other player we have heard about, by ID.
+    */
+    std::map<int, PlayerState> players;
+
+    /**
+    * Number of player records in the last reply.
+    */
+    int lastRecords = 0;
+
+    /**
+    * Merge a frame of "id x y score," records into players.
+    */
+    void readPlayers(const char* records);
+
+    /**
+    * Wait up to timeout milliseconds for a message on the socket. Negative timeouts wait forever.
+    */
+    bool waitFor(zmq::socket_t& socket, int timeout);
+
+public:
+    /**
+    * Create a connection that has not joined yet.
+    */
+    ClientConnection(Transport* transport);
+
+    /**
+    * Do the handshake with the server. Any previous sockets are thrown away first, so this also rejoins
+    * after the server has dropped us. If we have a token from an earlier join the server is asked to resume
+    * that session.
+    * @param timeout milliseconds to wait for the handshake reply. Negative waits forever.
+    * @return true if we got an ID and port.
+    */
+    bool join(int timeout = -1);
+
+    /**
+    * Send the direction we are steering our snake in (an Arena::DIRECTION), or -1 to keep going the way it is.
+    * The first one puts our snake in the room's arena.
+    */
+    void sendInput(int direction);
+
+    /**
+    * Set the bytes of other players we want per tic. Takes effect on the next join().
+    */
+    void setBudget(int budget);
+
+    /**
+    * Ask for a room, or -1 to let the server put us in one that isn't full. Takes effect on the next join() that
+    * starts a new session: a resumed session stays in its room.
+    */
+    void setRoom(int room);
+
+    /**
+    * Return the room we are in, or -1 if not joined.
+    */
+    int getRoom();
+
+    /**
+    * Follow the leaderboard or stop following it. Takes effect on the next join().
+    */
+    void setFollowLeaderboard(bool follow);
+
+    /**
+    * Apply every change to our room's leaderboard that has arrived. Doesn't wait.
+    * @return true if the leaderboard changed.
+    */
+    bool receiveLeaderboard();
+
+    /**
+    * Return the leaderboard as far as we have heard, best first. Empty until the first full leaderboard arrives.
+    */
+    const std::vector<LeaderboardEntry>* getLeaders();
+
+    /**
+    * Follow our room's board into view, or stop with nullptr. Takes effect on the next join(), after which the
+    * view waits for the room's next full board.
+    */
+    void setBoardView(BoardView* view);
+
+    /**
+    * Apply every board that has arrived for our room to the view. Doesn't wait.
+    * @return true if the view changed.
+    */
+    bool receiveBoard();
+
+    /**
+    * Return every other player we have heard about, by ID.
+    */
+    std::map<int, PlayerState>* getPlayers();
+
+    /**
+    * Return the number of player records in the last reply.
+    */
+    int getLastRecords();
+
+    /**
+    * Receive the reply to the last sendInput().
+    * @param reply set to the reply string.
+    * @param timeout milliseconds to wait. Negative waits forever.
+    * @return false if nothing arrived in time.
+    */
+    bool receiveReply(std::string* reply, int timeout = -1);
+
+    /**
+    * Receive the latest publisher update for our room.
+    * @param update set to the update string, without the room.
+    * @param timeout milliseconds to wait. 0 only takes what is already queued, negative waits forever.
+    * @return false if nothing arrived in time.
+    */
+    bool receiveUpdate(std::string* update, int timeout = -1);
+
+    /**
+    * Tell the server we are leaving and wait up to timeout milliseconds for it to confirm.
+    */
+    void leave(int timeout = -1);
+
+    /**
+    * Throw away the session token, so the next join() starts a new session.
+    */
+    void forget();
+
+    /**
+    * Return true if the last join() resumed our previous session.
+    */
+    bool wasResumed();
+
+    /**
+    * Return the score the server had recorded for our session when we last joined. 0 for a new session.
+    */
+    int getServerScore();
+
+    /**
+    * Return the handle of the request socket, for polling many connections at once.
+    */
+    void* getReplyHandle();
+
+    /**
+    * Return our ID, or -1 if not joined.
+    */
+    int getID();
+
+    /**
+    * Return our personal port, or -1 if not joined.
+    */
+    int getPort();
+};
+
+#endif
@@ -9,7 +9,8 @@ class Event : public GameObject {
 
 private:
 	v8::Isolate* isolate;
-	v8::Global<v8::Context>* context;
+	//Must start null, the destructor resets it if set.
+	v8::Global<v8::Context>* context = nullptr;
 
 	static void setEventGUID(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::PropertyCallbackInfo<void>& info);
 	static void getEventGUID(v8::Local<v8::String> property, const v8::PropertyCallbackInfo<v8::Value>& info); // note return type
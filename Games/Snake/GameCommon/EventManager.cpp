@@ -1,7 +1,5 @@
 #include "EventManager.h"
 
-std::map<int, std::multimap<int, Event>> EventManager::raised_events;
-
 EventManager::EventManager()
 {
 	this->window = NULL;
@@ -79,10 +77,36 @@ void EventManager::raise(Event e)
 	}
 }
 
+void EventManager::handleEvents(int64_t time)
+{
+	bool erase = false;
+	for (const auto& [eventTime, orderMap] : raised_events) {
+		if (eventTime <= time) {
+			for (const auto& [order, e] : orderMap) {
+				for (EventHandler* currentHandler : handlers.at(e.type)) {
+					currentHandler->onEvent(e);
+				}
+			}
+			//Erase the previous time now that we are past it.
+			if (erase) {
+				raised_events.erase(raised_events.begin());
+			}
+			erase = true;
+		}
+		else {
+			break;
+		}
+	}
+	if (erase) {
+		raised_events.erase(raised_events.begin());
+	}
+}
+
 void EventManager::raiseEventFromScript(const v8::FunctionCallbackInfo<v8::Value>& args)
 {
 	v8::Isolate* isolate = args.GetIsolate();
 	v8::Local<v8::Context> context = isolate->GetCurrentContext();
+	EventManager* manager = static_cast<EventManager*>(v8::Local<v8::External>::Cast(args.Data())->Value());
 	const char* value = v8helpers::ToCString(v8::String::Utf8Value(isolate, args[0]->ToString(context).ToLocalChecked()));
 	std::string find(value);
 	find + '\0';
@@ -93,5 +117,5 @@ void EventManager::raiseEventFromScript(const v8::FunctionCallbackInfo<v8::Value
 	catch (std::out_of_range) {
 		return;
 	}
-	raise(*(Event::events.at(value)));
+	manager->raise(*(Event::events.at(value)));
 }
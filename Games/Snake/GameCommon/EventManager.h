@@ -24,13 +24,28 @@ public:
 
 	void deregister(std::list<std::string>, EventHandler*);
 
-	static void raise(Event e);
+	void raise(Event e);
 
-	static std::map<int, std::multimap<int, Event>> raised_events;
+	/**
+	 * Run the handlers for every raised event whose time is at or before the given (global) time,
+	 * in time order and then raise order, and remove them from the queue.
+	 * Handlers may raise new events while this runs.
+	 */
+	void handleEvents(int64_t time);
+
+	/**
+	 * Events waiting to be handled, ordered by time and then by order. Each manager has its own queue,
+	 * so a server and any number of clients can run in the same process without sharing events.
+	 */
+	std::map<int, std::multimap<int, Event>> raised_events;
 
 	std::unordered_map<std::string, std::list<EventHandler*>> handlers;
     //Scripting stuff
 
+	/**
+	 * Callback for the script "raise" function. The manager to raise on must be passed as the
+	 * callback's data (a v8::External) when the function template is created.
+	 */
 	static void raiseEventFromScript(const v8::FunctionCallbackInfo<v8::Value>& args);
 
     std::string guid;
@@ -1,130 +1,282 @@
 #include "GameWindow.h"
+#include <algorithm>
+#include <cmath>
 
+GameWindow::GameWindow(World* world) {
+    this->world = world;
+    world->setObserver(this);
+}
+
+World* GameWindow::getWorld() {
+    return world;
+}
 
-GameWindow::GameWindow() {
+void GameWindow::objectAdded(const RegisteredObject& entry) {
+    GameObject* object = entry.object;
+    if (!object->isDrawable()) {
+        return;
+    }
+    bool batchable = BatchRenderer::canBatch(entry.rectangle);
+    if (object->isStatic() && batchable) {
+        staticBatch.add(entry.rectangle);
+    }
+    else if (object->isStatic()) {
+        staticDrawables.push_back(entry);
+    }
+    else if (batchable) {
+        batch.add(entry.rectangle);
+    }
+    else {
+        drawables.push_back(entry);
+    }
+    staticDirty = staticDirty || object->isStatic();
+}
 
-    innerMutex = (std::mutex*)malloc(sizeof(std::mutex));
-    std::mutex tempMutex;
-    if (innerMutex != NULL) {
-        memcpy(innerMutex, &tempMutex, sizeof(std::mutex));
+void GameWindow::objectChanged(const RegisteredObject& entry) {
+    GameObject* object = entry.object;
+    if (object->isDrawable() && object->isStatic()) {
+        staticBatch.update(entry.rectangle);
+        staticDirty = true;
+    }
+    else if (entry.rectangle != nullptr) {
+        batch.update(entry.rectangle);
     }
 }
 
-void GameWindow::clearStaticObjects()
-{
-    staticObjects.clear();
-    collidables.clear();
+void GameWindow::objectRemoved(const RegisteredObject& entry) {
+    GameObject* object = entry.object;
+    if (!object->isDrawable()) {
+        return;
+    }
+    std::vector<RegisteredObject>* list = object->isStatic() ? &staticDrawables : &drawables;
+    list->erase(std::remove_if(list->begin(), list->end(),
+        [object](const RegisteredObject& i) { return i.object == object; }), list->end());
+    if (object->isStatic()) {
+        staticBatch.remove(entry.rectangle);
+        staticDirty = true;
+    }
+    else {
+        batch.remove(entry.rectangle);
+    }
+}
+
+void GameWindow::objectsCleared() {
     drawables.clear();
+    batch.clear();
+    staticDrawables.clear();
+    staticBatch.clear();
+    staticDirty = true;
 }
 
-bool GameWindow::checkCollisions(GameObject** collides) {
-    bool foundCollision = false;
-    //Cycle through the list of collidables and check if they collide with the player.
-    {
-        std::lock_guard<std::mutex> lock(*innerMutex);
-        for (GameObject *i : collidables) {
+void GameWindow::update() {
+    publishFrame();
+    renderFrame();
+}
 
-            if ((dynamic_cast<sf::RectangleShape *>(character))->getGlobalBounds().intersects((dynamic_cast<sf::Shape *>(i))->getGlobalBounds())) {
-                // Return static collisions first.
-                *collides = i;
-                return true;
-            }
-        }
-        for (std::shared_ptr<GameObject> i : nonStaticObjects) {
-            if (i->isCollidable() && ( dynamic_cast<sf::RectangleShape*>(character) )->getGlobalBounds().intersects( dynamic_cast<sf::Shape*>( i.get() )->getGlobalBounds() ) ) {
-                // If the found collision is not moving, return it immediately
-                *collides = i.get();
-                return true;
+void GameWindow::publishFrame() {
+    //The observer calls that fill the batches hold the same lock.
+    std::lock_guard<std::mutex> lock(*world->getMutex());
+    FrameSnapshot* frame = frames.writeBuffer();
+    frame->view = requestedView;
 
+    //Statics are copied once per change and shared by every frame after that.
+    if (staticDirty || !staticScene) {
+        std::shared_ptr<StaticScene> scene(new StaticScene);
+        scene->generation = ++staticGeneration;
+        staticBatch.appendTo(&scene->vertices);
+        for (RegisteredObject& i : staticDrawables) {
+            if (i.rectangle != nullptr) {
+                scene->shapes.push_back(*i.rectangle);
             }
         }
+        staticScene = scene;
+        staticDirty = false;
+    }
+    frame->statics = staticScene;
 
+    //This buffer held a frame from two tics ago, so everything else is refilled.
+    frame->vertices.clear();
+    frame->shapes.clear();
+    batch.appendTo(&frame->vertices);
+    for (RegisteredObject& i : drawables) {
+        if (i.rectangle != nullptr) {
+            frame->shapes.push_back(*i.rectangle);
+        }
     }
-    // No collision found.
-    return false;
-}
+    //Server objects and the character change every tic, so they go through the frame batch.
+    for (RegisteredObject& i : *world->getNonStaticRegistered()) {
+        if (i.rectangle == nullptr || !i.object->isDrawable()) {
+            continue;
+        }
+        if (BatchRenderer::canBatch(i.rectangle)) {
+            frameBatch.append(*i.rectangle);
+        }
+        else {
+            frame->shapes.push_back(*i.rectangle);
+        }
+    }
+    RegisteredObject* player = world->getPlayer();
+    if (BatchRenderer::canBatch(player->rectangle)) {
+        frameBatch.append(*player->rectangle);
+    }
+    else if (player->rectangle != nullptr) {
+        frame->shapes.push_back(*player->rectangle);
+    }
+    frameBatch.appendTo(&frame->vertices);
+    frame->texts.swap(pendingTexts);
+    pendingTexts.clear();
 
-//Add this client's playable character.
-void GameWindow::addPlayableObject(GameObject* character) {
-    std::lock_guard<std::mutex> lock(*innerMutex);
-    this->character = character;
+    frameBatch.clear();
+    frames.publish();
 }
 
-GameObject* GameWindow::getPlayableObject() {
-    std::lock_guard<std::mutex> lock(*innerMutex);
-    return character;
+bool GameWindow::renderFrame() {
+    if (!frames.consume()) {
+        return false;
+    }
+    drawFrame(*frames.readBuffer());
+    return true;
 }
 
-void GameWindow::addGameObject(GameObject *object) {
-    std::lock_guard<std::mutex> lock(*innerMutex);
-    if (object->isStatic()) {
-        staticObjects.push_back(object);
+void GameWindow::drawFrame(const FrameSnapshot& frame) {
+    setView(frame.view);
+    clear();
+    //Walls and other static drawables come from the cached layer, or straight from the scene if there is none.
+    if (!drawStaticLayer(frame) && frame.statics) {
+        if (!frame.statics->vertices.empty()) {
+            draw(frame.statics->vertices.data(), frame.statics->vertices.size(), sf::Triangles);
+        }
+        for (const sf::RectangleShape& i : frame.statics->shapes) {
+            draw(i);
+        }
     }
-    if (object->isCollidable()) {
-        collidables.push_back(object);
+    //Every moving rectangle in one call.
+    if (!frame.vertices.empty()) {
+        draw(frame.vertices.data(), frame.vertices.size(), sf::Triangles);
     }
-    if (object->isDrawable()) {
-        drawables.push_back(object);
+    //Textured rectangles and text can't share a batch.
+    for (const sf::RectangleShape& i : frame.shapes) {
+        draw(i);
+    }
+    text.setFont(font);
+    for (const TextState& i : frame.texts) {
+        text.setString(i.text);
+        text.setPosition(i.position);
+        text.setCharacterSize(i.size);
+        text.setFillColor(i.color);
+        draw(text);
     }
-}
-//Contains client objects like death bounds and side bounds.
-std::list<GameObject*>* GameWindow::getStaticObjects() {
-    std::lock_guard<std::mutex> lock(*innerMutex);
-    return &staticObjects;
-}
-//Contains server objects like moving platforms and other characters.
-std::list<std::shared_ptr<GameObject>>* GameWindow::getNonstaticObjects() {
-    std::lock_guard<std::mutex> lock(*innerMutex);
-    return &nonStaticObjects;
 }
 
-void GameWindow::update() {
-    std::lock_guard<std::mutex> lock(*innerMutex);
-    clear();
-    //Cycle through the list of platforms and draw them.
-    for (GameObject* i : drawables) {
-        draw(*(dynamic_cast<sf::Drawable*>(i)));
+bool GameWindow::drawStaticLayer(const FrameSnapshot& frame) {
+    if (staticLayerFailed || !frame.statics) {
+        return false;
+    }
+    const sf::View& view = frame.view;
+    sf::Vector2u size = getSize();
+    //Minimized, or not open yet.
+    if (size.x == 0 || size.y == 0) {
+        return false;
+    }
+    //Window pixels per world unit along each axis. The view can stretch the world when scaling isn't proportional.
+    sf::Vector2f scale(size.x * view.getViewport().width / view.getSize().x, size.y * view.getViewport().height / view.getSize().y);
+    if (frame.statics->generation != layerGeneration || scale != layerScale) {
+        staticTiles.clear();
+        layerGeneration = frame.statics->generation;
+        layerScale = scale;
     }
-    for (std::shared_ptr<GameObject> i : nonStaticObjects) {
-        if (i->isDrawable()) {
-            draw(*(dynamic_cast<sf::Drawable*>(i.get())));
+    frameCount++;
+
+    //The tiles under the view, in world units.
+    sf::Vector2f tileSize(STATIC_TILE_PIXELS / scale.x, STATIC_TILE_PIXELS / scale.y);
+    sf::FloatRect visible = view.getInverseTransform().transformRect(sf::FloatRect(-1.f, -1.f, 2.f, 2.f));
+    int firstColumn = (int)std::floor(visible.left / tileSize.x);
+    int lastColumn = (int)std::floor((visible.left + visible.width) / tileSize.x);
+    int firstRow = (int)std::floor(visible.top / tileSize.y);
+    int lastRow = (int)std::floor((visible.top + visible.height) / tileSize.y);
+    if ((int64_t)(lastColumn - firstColumn + 1) * (lastRow - firstRow + 1) > MAX_STATIC_TILES) {
+        return false;
+    }
+
+    visibleTiles.clear();
+    bool rendered = false;
+    for (int column = firstColumn; column <= lastColumn; column++) {
+        for (int row = firstRow; row <= lastRow; row++) {
+            sf::Vector2f origin(column * tileSize.x, row * tileSize.y);
+            int64_t key = ((int64_t)column << 32) | (uint32_t)row;
+            auto found = staticTiles.find(key);
+            if (found == staticTiles.end()) {
+                //Make room by dropping the tile that has been out of view longest.
+                if (staticTiles.size() >= MAX_STATIC_TILES) {
+                    auto oldest = staticTiles.begin();
+                    for (auto i = staticTiles.begin(); i != staticTiles.end(); i++) {
+                        if (i->second->lastFrame < oldest->second->lastFrame) {
+                            oldest = i;
+                        }
+                    }
+                    staticTiles.erase(oldest);
+                }
+                std::unique_ptr<StaticTile> tile(new StaticTile);
+                if (!tile->texture.create(STATIC_TILE_PIXELS, STATIC_TILE_PIXELS)) {
+                    staticLayerFailed = true;
+                    staticTiles.clear();
+                    setActive(true);
+                    return false;
+                }
+                tile->texture.setView(sf::View(sf::FloatRect(origin, tileSize)));
+                tile->texture.clear(sf::Color::Transparent);
+                if (!frame.statics->vertices.empty()) {
+                    tile->texture.draw(frame.statics->vertices.data(), frame.statics->vertices.size(), sf::Triangles);
+                }
+                for (const sf::RectangleShape& i : frame.statics->shapes) {
+                    tile->texture.draw(i);
+                }
+                tile->texture.display();
+                rendered = true;
+                found = staticTiles.insert({ key, std::move(tile) }).first;
+            }
+            found->second->lastFrame = frameCount;
+            visibleTiles.push_back({ origin, found->second.get() });
         }
     }
-    draw(*(dynamic_cast<sf::Drawable*>(character)));
-    nonStaticObjects.clear();
-    //display();
+    //Drawing into a texture switched GL contexts.
+    if (rendered) {
+        setActive(true);
+    }
+
+    //Each tile goes where it is in the world, so the frame's view places it like any other drawable.
+    sf::Sprite sprite;
+    sprite.setScale(1.f / scale.x, 1.f / scale.y);
+    for (std::pair<sf::Vector2f, StaticTile*>& i : visibleTiles) {
+        sprite.setTexture(i.second->texture.getTexture(), true);
+        sprite.setPosition(i.first);
+        draw(sprite);
+    }
+    return true;
 }
 
-void GameWindow::addTemplate(std::shared_ptr<GameObject> templateObject) {
-    templates.insert_or_assign(templateObject->getObjectType(), templateObject);
+void GameWindow::drawText(const std::string& text, sf::Vector2f position, unsigned int size, sf::Color color) {
+    std::lock_guard<std::mutex> lock(*world->getMutex());
+    pendingTexts.push_back({ text, position, size, color });
 }
 
-void GameWindow::updateNonStatic(std::string updates) {
-    std::lock_guard<std::mutex> lock(*innerMutex);
+bool GameWindow::loadFont(const std::string& path) {
+    return font.loadFromFile(path);
+}
 
-    char* currentObject = (char*)malloc(updates.size() + 1);
-    if (currentObject == NULL) {
-        throw std::runtime_error("Memory error while updating static objects");
-    }
-    int pos = 0;
-    int newPos = 0;
+void GameWindow::requestView(sf::View view) {
+    std::lock_guard<std::mutex> lock(*world->getMutex());
+    requestedView = view;
+}
 
-    //Scan through each object
-    while (sscanf_s(updates.data() + pos, "%[^,]%n", currentObject,(unsigned int)(updates.size() + 1), &newPos) == 1) {
-        //Get the type of the current object.
-        int type;
-        int matches = sscanf_s(currentObject, "%d", &type);
-        if (matches != 1) {
-            free(currentObject);
-            throw std::invalid_argument("Failed to read string. Type must be the first value.");
-        }
-        //Push the newly created object into the array.
-        nonStaticObjects.push_back((templates.at(type))->constructSelf(currentObject));
-        //update position and skip past comma
-        pos += newPos + 1;
+sf::View GameWindow::getRequestedView() {
+    std::lock_guard<std::mutex> lock(*world->getMutex());
+    return requestedView;
+}
 
-    }
-    free(currentObject);
+void GameWindow::drawBatched(const sf::RectangleShape& shape) {
+    std::lock_guard<std::mutex> lock(*world->getMutex());
+    frameBatch.append(shape);
 }
 
 void GameWindow::changeScaling() {
@@ -138,6 +290,6 @@ bool GameWindow::checkMode() {
 void GameWindow::handleResize(sf::Event event) {
     if (!isProportional) {
         sf::FloatRect visibleArea(0, 0, (float)event.size.width, (float)event.size.height);
-        setView(sf::View(visibleArea));
+        requestView(sf::View(visibleArea));
     }
 }
\ No newline at end of file
@@ -1,130 +1,259 @@
 #ifndef GAMEWINDOW_H
 #define GAMEWINDOW_H
 
-#include <list>
+#include <vector>
 #include <iostream>
-#include "Character.h"
-#include "Platform.h"
+#include <memory>
+#include <unordered_map>
+#include "World.h"
+#include "BatchRenderer.h"
+#include "TripleBuffer.h"
+
+//Width and height in pixels of each tile of the static layer.
+#define STATIC_TILE_PIXELS 512
+//Tiles of the static layer kept at once. The ones unused longest go first.
+#define MAX_STATIC_TILES 32
+
+/**
+* Text to draw in one frame.
+*/
+struct TextState {
+    std::string text;
+    sf::Vector2f position;
+    unsigned int size;
+    sf::Color color;
+};
+
+/**
+* The static drawables as they were when a frame was published. Shared by every frame until statics change, and
+* never modified after it is built.
+*/
+struct StaticScene {
+    /**
+    * Counts the scenes a window has built, so a new one is never taken for an old one that was freed.
+    */
+    int64_t generation = 0;
+    std::vector<sf::Vertex> vertices;
+    /**
+    * Copies of the textured static rectangles.
+    */
+    std::vector<sf::RectangleShape> shapes;
+};
+
+/**
+* Everything needed to draw one frame, copied out of the window at the end of a tic. The render thread only ever
+* reads these, so it never touches the objects the simulation is changing.
+*/
+struct FrameSnapshot {
+    sf::View view;
+    std::shared_ptr<const StaticScene> statics;
+    /**
+    * Every solid rectangle that isn't static, two triangles each.
+    */
+    std::vector<sf::Vertex> vertices;
+    /**
+    * Copies of the textured rectangles that aren't static.
+    */
+    std::vector<sf::RectangleShape> shapes;
+    std::vector<TextState> texts;
+};
 
 /**
-* GameWindow is a class that handles collisions and rendering the window.
-* You can create a list of collidables, assign a character to the window, and a list of platforms.
-* Then the methods will handle collision detection automatically with CheckCollisions.
+* GameWindow draws a World. It watches the world's objects as they are added, moved and cleared and keeps batched
+* copies of them, so drawing never has to walk the world's lists.
+* Collisions and objects are managed by the World. Code that doesn't draw should only need that.
 */
-class GameWindow : public sf::RenderWindow {
+class GameWindow : public sf::RenderWindow, public WorldObserver {
 
 private:
 
     /**
-    * The list of platform pointers that need to be drawn on screen.
+    * The world this window draws.
+    */
+    World* world;
+    /**
+    * The moving drawables that can't be batched (textured or not a rectangle), in the order they were added.
     */
-    std::list<GameObject*> staticObjects;
+    std::vector<RegisteredObject> drawables;
     /**
-    * The list of static objects added to the window
+    * Every batchable moving drawable added to the window. Drawn with one call.
     */
-    std::list<std::shared_ptr<GameObject>> nonStaticObjects;
+    BatchRenderer batch;
     /**
-    * The list of collidables added to the window
+    * The static drawables. They reach the screen through staticScene and staticLayer.
     */
-    std::list<GameObject*> collidables;
+    std::vector<RegisteredObject> staticDrawables;
+    BatchRenderer staticBatch;
     /**
-    * The list of drawables added to the window
+    * Set when statics were added, moved or cleared since staticScene was built.
     */
-    std::list<GameObject*> drawables;
+    bool staticDirty = true;
     /**
-    * Templates used in the drawing/collisions of non-static objects.
+    * The statics handed to every frame since they last changed.
     */
-    std::map<int, std::shared_ptr<GameObject>> templates;
+    std::shared_ptr<const StaticScene> staticScene;
+    /**
+    * Generation of staticScene. Bumped every time statics change and it is built again.
+    */
+    int64_t staticGeneration = 0;
 
     /**
-    * The single, playable character object in the window. Should be a sprite.
+    * The non-static objects, the character and anything passed to drawBatched() this frame. Refilled every frame.
     */
-    GameObject* character;
+    BatchRenderer frameBatch;
 
     /**
-    * Whether or not the window uses proportional scaling.
+    * Frames on their way from publishFrame() to renderFrame().
     */
-    bool isProportional = true;
+    TripleBuffer<FrameSnapshot> frames;
+    /**
+    * The view the next published frame is drawn with.
+    */
+    sf::View requestedView;
+    /**
+    * Text to draw in the next published frame.
+    */
+    std::vector<TextState> pendingTexts;
+    /**
+    * The font texts are drawn with.
+    */
+    sf::Font font;
+
+    //Everything below is only used by the thread calling renderFrame().
 
     /**
-    * The mutex for handling inner mutual exclusion
+    * One square of staticScene, rendered at window resolution.
+    */
+    struct StaticTile {
+        sf::RenderTexture texture;
+        /**
+        * The last frame the tile was in view.
+        */
+        int64_t lastFrame = 0;
+    };
+    /**
+    * staticScene rendered in world space, in tiles of STATIC_TILE_PIXELS keyed by their column and row. A tile is
+    * rendered the first time the view reaches it and blitted at its place in the world every frame after that, so
+    * following the player only ever renders the tiles coming into view.
     */
-    std::mutex *innerMutex;
+    std::unordered_map<int64_t, std::unique_ptr<StaticTile>> staticTiles;
+    /**
+    * Set if a render texture couldn't be created. Static drawables are then drawn straight to the window.
+    */
+    bool staticLayerFailed = false;
+    /**
+    * The generation of the scene and the window pixels per world unit the tiles were rendered with. A change to
+    * either throws them all away. Moving or rotating the view doesn't.
+    */
+    int64_t layerGeneration = -1;
+    sf::Vector2f layerScale;
+    /**
+    * Frames drawn so far.
+    */
+    int64_t frameCount = 0;
+    /**
+    * The tiles to blit this frame. Reused every frame.
+    */
+    std::vector<std::pair<sf::Vector2f, StaticTile*>> visibleTiles;
+    /**
+    * Reused for every text drawn.
+    */
+    sf::Text text;
 
+    /**
+    * Draw the frame's statics from the tiles in view, rendering any that are missing.
+    * @return false if they have to be drawn straight to the window instead: there is no render texture, or the
+    * view is zoomed out too far for MAX_STATIC_TILES to cover it.
+    */
+    bool drawStaticLayer(const FrameSnapshot& frame);
 
+    /**
+    * Draw a frame to the window.
+    */
+    void drawFrame(const FrameSnapshot& frame);
 
+    /**
+    * Whether or not the window uses proportional scaling.
+    */
+    bool isProportional = true;
 
 public:
     /**
-    Empty constructor. Same as RenderWindow
+    * Create a window that draws the given world. Same as RenderWindow otherwise.
     */
-    GameWindow();
-
-    void clearStaticObjects();
+    GameWindow(World* world);
 
     /**
-    Check collisions of all collidables versus the character.
-    @param collides Returns the CBox that the character collided with (stationary platforms take precedence)
-    I.E if a player is colliding with both a moving platform and a stationary platform, the stationary platform will be returned here.
-    @return boolean value for if a collision was found.
+    * The world this window draws.
     */
-    bool checkCollisions(GameObject** collides);
+    World* getWorld();
+
+    void objectAdded(const RegisteredObject& object) override;
+    void objectChanged(const RegisteredObject& object) override;
+    void objectRemoved(const RegisteredObject& object) override;
+    void objectsCleared() override;
 
     /**
-    * Add a platform to the window. By default it is added to the list of platforms and collidables.
+    * publishFrame() and then renderFrame(), for drawing from the simulation thread. Doesn't display.
     */
-    void addGameObject(GameObject* object);
+    void update();
 
     /**
-    * Add the playable character to the window. Only one character is supported.
+    * Copy everything drawable into a snapshot for the renderer. Call at the end of each tic. Never waits on the
+    * renderer: if it hasn't taken the last frame yet, that frame is replaced.
+    * Anything passed to drawBatched() or drawText() is used up.
     */
-    void addPlayableObject(GameObject* character);
+    void publishFrame();
 
     /**
-    * Update the window by clearing the window, drawing each object, and then displaying it.
+    * Clear the window and draw the newest published frame, if there is one that hasn't been drawn. Solid
+    * rectangles are drawn in batches, so the number of draw calls doesn't grow with the number of objects.
+    * Textured shapes and text are drawn after them. Call from the thread the window is active on, then display().
+    * @return false if no new frame was published.
     */
-    void update();
+    bool renderFrame();
 
     /**
-    * Checks the mode of the window. True for proportional, false if not.
+    * Draw text in the next published frame with the window's font.
     */
-    bool checkMode();
+    void drawText(const std::string& text, sf::Vector2f position, unsigned int size, sf::Color color);
 
     /**
-    * Change the scaling of the window. If it is currently constant, it will change to proportional, and vice versa.
+    * Load the font drawText() uses. Call before rendering starts.
     */
-    void changeScaling();
+    bool loadFont(const std::string& path);
 
     /**
-    * If the current view is constant, this will resize the view to fit the new size
+    * Use this view from the next published frame on. Safe to call from any thread, unlike setView().
     */
-    void handleResize(sf::Event event);
+    void requestView(sf::View view);
 
     /**
-    * Return the list of static objects.
+    * Return the view the next published frame is drawn with.
     */
-    std::list<GameObject*>* getStaticObjects();
+    sf::View getRequestedView();
 
     /**
-    * Return the list of platforms (realPlatforms) in the window.
-    * @param n the number of real platforms in the window.
+    * Draw a copy of the rectangle in the next published frame, batched with the other rectangles. The shape can be changed
+    * and passed again straight away.
     */
-    std::list<std::shared_ptr<GameObject>>* getNonstaticObjects();
+    void drawBatched(const sf::RectangleShape& shape);
 
     /**
-    * return a pointer to the character.
+    * Checks the mode of the window. True for proportional, false if not.
     */
-    GameObject* getPlayableObject();
+    bool checkMode();
 
     /**
-    * Update the characters using a string that contains information about all of the updated characters.
+    * Change the scaling of the window. If it is currently constant, it will change to proportional, and vice versa.
     */
-    void updateNonStatic(std::string updates);
+    void changeScaling();
 
     /**
-    * Add an empty template object to the gamewindow.
+    * If the current view is constant, this will resize the view to fit the new size
     */
-    void addTemplate(std::shared_ptr<GameObject> templateObject);
+    void handleResize(sf::Event event);
+
 };
 
 #endif
\ No newline at end of file
@@ -1,15 +1,18 @@
 #include "Handlers.h"
 
+CollisionHandler::CollisionHandler(World* world)
+{
+    this->world = world;
+}
+
 void CollisionHandler::onEvent(Event e)
 {
-    GameObject* collision;
     Character* character;
     bool* upPressed;
     bool* doGravity;
     float ticLength;
     int differential;
     try {
-        collision = e.parameters.at(std::string("collision")).m_asGameObject;
         character = (Character*)e.parameters.at(std::string("character")).m_asGameObject;
         upPressed = e.parameters.at(std::string("upPressed")).m_asBoolP;
         doGravity = e.parameters.at(std::string("doGravity")).m_asBoolP;
@@ -21,55 +24,58 @@ void CollisionHandler::onEvent(Event e)
         exit(3);
     }
 
-    float oneHalfTicGrav = (character->getGravity() * ticLength) / 2;
-    //If the collided object is not moving, correct the position by moving up one.
-                    //NOTE: This should be impossible unless a platform was generated at the player's location (Since it's not a moving platform).
-    if (collision->getObjectType() == Platform::objectType) {
-        Platform* temp = (Platform*)collision;
-        character->setPosition(character->getPosition().x, temp->getGlobalBounds().top - character->getGlobalBounds().height - oneHalfTicGrav);
-        //Enable jumping. TODO: Rename variable to better fit. canJump? canJump(bool)?
-        *upPressed = true;
-        //We just teleported up to the top of a stationary platform, no need for gravity.
-        *doGravity = false;
-    }
-    else if (collision->getObjectType() == MovingPlatform::objectType) {
-        MovingPlatform* temp = (MovingPlatform*)collision;
-        float platSpeed = (float)temp->getSpeedValue() * (float)ticLength * (float)(differential);
-        float oneHalfTicPlat = ((float)temp->getSpeedValue() * (float)ticLength) / 2;
-
-        //If the platform is moving horizontally.
-        if (temp->getMovementType()) {
-            //Since gravity hasn't happened yet, this must be a collision where it hit us from the x-axis, so put the character to the side of it.
-            if (platSpeed < 0.f) {
-                //If the platform is moving left, set us to the left of it.
-                character->setPosition(temp->getGlobalBounds().left - character->getGlobalBounds().width - abs(oneHalfTicPlat), character->getPosition().y);
+    //Everything the character is touching, found once and resolved in one pass, so a platform and a side bound
+    //hit on the same tic are both dealt with.
+    Contact contacts[MAX_CONTACTS];
+    int count = world->checkContacts(contacts, MAX_CONTACTS);
+    for (int i = 0; i < count; i++) {
+        Contact& contact = contacts[i];
+        GameObject* collision = contact.object;
+        if (collision->getObjectType() == Platform::objectType) {
+            //Out the way we came in, by exactly as far as we went in.
+            character->move(contact.normal * contact.depth);
+            if (contact.normal.y < 0.f) {
+                //Standing on top of it. We can jump, and gravity has nothing to do.
+                *upPressed = true;
+                *doGravity = false;
+            }
+        }
+        else if (collision->getObjectType() == MovingPlatform::objectType) {
+            MovingPlatform* temp = (MovingPlatform*)collision;
+            //How far the platform moved since the last tic, however late this one is.
+            float distance = (float)temp->getSpeedValue() * ticLength * (float)differential;
+            sf::Vector2f motion = temp->getMovementType() ? sf::Vector2f(distance, 0.f) : sf::Vector2f(0.f, distance);
+            //Seen from the platform, we moved the other way. Sweep that back to where we first touched it, and the
+            //platform carries us the rest of its motion from there.
+            sf::FloatRect bounds = character->getGlobalBounds();
+            sf::FloatRect before(bounds.left + motion.x, bounds.top + motion.y, bounds.width, bounds.height);
+            float time;
+            sf::Vector2f normal;
+            sf::Vector2f push;
+            if (SpatialHash::sweepBox(before, -motion, contact.bounds, &time, &normal)) {
+                push = motion * (1.f - time);
             }
             else {
-                //If the platform is moving right, set us to the right of it
-                character->setPosition(temp->getGlobalBounds().left + temp->getGlobalBounds().width + abs(oneHalfTicPlat), character->getPosition().y);
+                //We were already inside it a tic ago. Out the shortest way.
+                normal = contact.normal;
+                push = contact.normal * contact.depth;
             }
-        }
-        //If the platform is moving vertically
-        else {
-            //If the platform is currently moving upwards
-            if (platSpeed < 0.f) {
-                //At this point, we know that we have been hit by a platform moving upwards, so correct our position upwards.
-                character->setPosition(character->getPosition().x, temp->getGlobalBounds().top - character->getGlobalBounds().height - abs(oneHalfTicPlat));
-                //We are above a platform, we can jump.
+            //Being carried can't take us through anything else.
+            Contact hit;
+            if (world->sweepContact(bounds, push, &hit)) {
+                push = push * hit.time;
+            }
+            character->move(push);
+            if (normal.y < 0.f) {
+                //On top of it. We can jump, and gravity has nothing to do.
                 *upPressed = true;
-                //We just got placed above a platform, no need to do gravity.
                 *doGravity = false;
             }
-            //If the platform is moving downwards
-            else {
-                //Gravity will (probably) take care of it, but just in case, correct our movement to the bottom of the platform.
-                character->setPosition(character->getPosition().x, temp->getGlobalBounds().top + temp->getGlobalBounds().height + oneHalfTicPlat);
-            }
         }
-    }
-    else if (collision->getObjectType() == SideBound::objectType) {
-        SideBound* sb = (SideBound*)collision;
-        sb->onCollision();
+        else if (collision->getObjectType() == SideBound::objectType) {
+            SideBound* sb = (SideBound*)collision;
+            sb->onCollision();
+        }
     }
 }
 
@@ -99,10 +105,10 @@ void MovementHandler::onEvent(Event e)
     }
 }
 
-GravityHandler::GravityHandler(EventManager *em, GameWindow *window, ScriptManager *sm)
+GravityHandler::GravityHandler(EventManager *em, World *world, ScriptManager *sm)
 {
     this->em = em;
-    this->window = window;
+    this->world = world;
     this->sm = sm;
 }
 
@@ -119,92 +125,65 @@ void GravityHandler::onEvent(Event e)
     }
     //Only do ANY of this if we are moving.
     if (!(character->getSpeed().x == 0 && character->getSpeed().y == 0)) {
-        GameObject* collision;
-        sf::Vector2f oldBack = character->getPosition();
-        if (character->trail.size() != 0) {
-            //Take a reference to the back.
-            Character* back = character->trail.back();
-            //Save it for if we found an apple.
-            oldBack = back->getPosition();
-            //Pop it off and add it to the front, at the same position character is at.
-            character->trail.pop_back();
-            back->setPosition(character->getPosition());
-            character->trail.push_front(back);
-        }
+        OccupancyGrid* board = character->board;
+        //The head's cell becomes the front of the body.
+        int oldCell = board->cellAt(character->getPosition());
         //Move character forward
         sm->addArgs(character);
         sm->runOne("move_character");
         //character->move(character->getSpeed());
-        //Erase the position my character is in from the unoccupied list.
-        for (std::list<sf::Vector2f>::iterator it = character->unoccupied.begin(); it != character->unoccupied.end();)
-        {
-            //Erase the position my character is in from the unoccupied list.
-            if (*it == character->getPosition()) {
-                character->unoccupied.erase(it);
-                break;
-            }
-            else {
-                it++;
-            }
+        //One lookup decides what we ran into.
+        int headCell = board->cellAt(character->getPosition());
+        OccupancyGrid::CONTENT content = board->contentAt(headCell);
+        //The tail moves off its cell this tic, so running into it is safe.
+        if (content == OccupancyGrid::BODY && headCell == character->body.back()) {
+            content = OccupancyGrid::EMPTY;
         }
+        character->body.pushFront(oldCell);
+        board->occupy(headCell);
+        bool hitWall = content == OccupancyGrid::WALL || content == OccupancyGrid::BODY || content == OccupancyGrid::SNAKE;
+        bool hitApple = content == OccupancyGrid::APPLE;
 
-        //Check collisions after character movement.
-        if (window->checkCollisions(&collision)) {
-            //If the collision was a wall or its tail.
-            if ((collision->getObjectType() == Character::objectType || collision->getObjectType() == Platform::objectType) && !character->isDead()) {
-                Event death;
-                character->died();
-                Event::variant characterVariant;
-                characterVariant.m_Type = Event::variant::TYPE_GAMEOBJECT;
-                characterVariant.m_asGameObject = character;
-                death.parameters.insert({ "character", characterVariant });
-                death.type = "death";
-                death.time = e.time;
-                death.order = e.order + 1;
-                em->raise(death);
-            }
-            //If the collision was an apple (Moving platform)
-            else if (collision->getObjectType() == MovingPlatform::objectType && !character->isDead()) {
-                //Hit apple
-                Character* newCharacter = new Character;
-                //Set the new character piece at where the old back used to be (Should be blank now).
-                newCharacter->setPosition(oldBack);
-                character->trail.push_back(newCharacter);
-                window->addGameObject(newCharacter);
-
-                //Generate new apple position.
-                srand(time(NULL));
-                int appleIndex = rand() % character->unoccupied.size();
-                int count = 0;
-                sf::Vector2f newPosition;
-                std::list<sf::Vector2f>::iterator it = character->unoccupied.begin();
-                bool found = false;
-                for (sf::Vector2f i : character->unoccupied) {
-                    if (count == appleIndex) {
-                        newPosition = i;
-                        found = true;
-                        break;
-                    }
-                    it++;
-                    count++;
-                }
+        //Dying wins over eating an apple in the same square.
+        bool grew = false;
+        if (hitWall && !character->isDead()) {
+            Event death;
+            character->died();
+            Event::variant characterVariant;
+            characterVariant.m_Type = Event::variant::TYPE_GAMEOBJECT;
+            characterVariant.m_asGameObject = character;
+            death.parameters.insert({ "character", characterVariant });
+            death.type = "death";
+            death.time = e.time;
+            death.order = e.order + 1;
+            em->raise(death);
+        }
+        else if (hitApple && !character->isDead()) {
+            //Hit apple. The tail stays put this tic, so the body is one longer.
+            grew = true;
+            //Generate new apple position. A full board leaves it where it is.
+            int appleCell = board->randomFree();
+            if (appleCell != -1) {
                 //Change the apple's position to the generated one.
-                character->apple->setPosition(newPosition);
-                character->length++;
-            }
-            else {
-                character->unoccupied.push_back(oldBack);
+                board->occupy(appleCell, OccupancyGrid::APPLE);
+                character->apple->setPosition(board->positionOf(appleCell));
+                world->refreshGameObject(character->apple);
             }
+            character->length++;
         }
-        else {
-            character->unoccupied.push_back(oldBack);
+        if (!grew) {
+            //The tail moves off its old cell, unless the head just moved into it.
+            int tail = character->body.popBack();
+            if (tail != headCell) {
+                board->release(tail);
+            }
         }
     }
 }
 
-SpawnHandler::SpawnHandler(GameWindow* window)
+SpawnHandler::SpawnHandler(World* world)
 {
-    this->window = window;
+    this->world = world;
 }
 
 void SpawnHandler::onEvent(Event e)
@@ -219,63 +198,19 @@ void SpawnHandler::onEvent(Event e)
     }
     //Clear trail
     character->length = 0;
-    character->trail.clear();
-    character->unoccupied.clear();
-    //Repopulate unoccupied list
-    for (int i = 0; i < 780 / character->getSize().x; i++) {
-        for (int j = 0; j < 580 / character->getSize().y; j++) {
-            //Skip first square (Character will be here).
-            if (!(i == 0 && j== 0)) {
-                character->unoccupied.push_back(sf::Vector2f(i * character->getSize().x + 10, j * character->getSize().y + 10));
-            }
-        }
-    }
-    //Clear trail from window.
-    window->clearStaticObjects();
+    character->body.clear();
+    //Back to the level as it was built, in one copy. Only the square the character spawns in is taken.
+    character->respawn();
+    character->level->reset(character->board);
+    character->board->occupy(character->board->cellAt(character->getPosition()));
 
-    //Regenerate apple
-    int appleIndex = rand() % character->unoccupied.size();
-    int count = 0;
-    sf::Vector2f newPosition;
-    std::list<sf::Vector2f>::iterator it = character->unoccupied.begin();
-    for (sf::Vector2f i : character->unoccupied) {
-        if (count == appleIndex) {
-            newPosition = i;
-            break;
-            //character->unoccupied.erase(it);
-        }
-        it++;
-        count++;
+    //Regenerate apple. A full board leaves it where it is.
+    int appleCell = character->board->randomFree();
+    if (appleCell != -1) {
+        character->board->occupy(appleCell, OccupancyGrid::APPLE);
+        character->apple->setPosition(character->board->positionOf(appleCell));
+        world->refreshGameObject(character->apple);
     }
-    //Change the apple's position to the generated one.
-    character->apple->setPosition(newPosition);
-    window->addGameObject(character->apple);
-    //Add the boundaries back to the window
-    Platform *bottom = new Platform;
-    bottom->setSize(sf::Vector2f(800, 10.f));
-    bottom->setFillColor(sf::Color(100, 0, 0));
-    bottom->setPosition(sf::Vector2f(0, 590));
-    window->addGameObject(bottom);
-
-    Platform *right = new Platform;
-    right->setSize(sf::Vector2f(10, 580));
-    right->setFillColor(sf::Color(100, 0, 0));
-    right->setPosition(sf::Vector2f(790, 10));
-    window->addGameObject(right);
-
-    Platform *left = new Platform;
-    left->setSize(sf::Vector2f(10, 580));
-    left->setFillColor(sf::Color(100, 0, 0));
-    left->setPosition(sf::Vector2f(0, 10));
-    window->addGameObject(left);
-
-    Platform* top = new Platform;
-    top->setSize(sf::Vector2f(800, 10.f));
-    top->setFillColor(sf::Color(100, 0, 0));
-    top->setPosition(sf::Vector2f(0, 0));
-    window->addGameObject(top);
-    //Respawn the character
-    character->respawn();
 }
 
 DeathHandler::DeathHandler(EventManager* em, ScriptManager*sm)
@@ -7,9 +7,21 @@
 #include "SideBound.h"
 #include "EventManager.h"
 #include "ScriptManager.h"
+#include "World.h"
+#include "Level.h"
 #include <zmq.hpp>
+/**
+* Pushes the character out of everything it overlaps in the world: on top of or beside platforms, and along with
+* moving platforms from the time of impact a swept test finds, so a late tic can't carry the character through one.
+* Side bounds are told they were hit. Takes "character", "upPressed" and "doGravity" (set when it ends
+* up standing on something), "ticLength" and "differential" (tics since the last one).
+*/
 class CollisionHandler : public EventHandler {
+private:
+	World* world;
 public:
+	CollisionHandler(World* world);
+
 	void onEvent(Event e) override;
 };
 
@@ -27,19 +39,19 @@ public:
 class GravityHandler : public EventHandler {
 private:
 	EventManager *em;
-	GameWindow* window;
+	World* world;
 	ScriptManager* sm;
 public:
-	GravityHandler(EventManager *em, GameWindow *window, ScriptManager *sm);
+	GravityHandler(EventManager *em, World *world, ScriptManager *sm);
 
 	void onEvent(Event e) override;
 };
 
 class SpawnHandler : public EventHandler {
 private:
-	GameWindow* window;
+	World* world;
 public:
-	SpawnHandler(GameWindow* window);
+	SpawnHandler(World* world);
 	void onEvent(Event e) override;
 };
 
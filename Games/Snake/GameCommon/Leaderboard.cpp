@@ -0,0 +1,147 @@
+#include "Leaderboard.h"
+#include <algorithm>
+#include <cstdio>
+
+/**
+* Best first. Ties go to the lower ID so every shard and subscriber orders them the same.
+*/
+static bool ranksAbove(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+    return a.score > b.score || (a.score == b.score && a.id < b.id);
+}
+
+Leaderboard::Leaderboard(int shards) : shards(new Shard[shards]) {
+    shardCount = shards;
+    best = 1;
+    changed = false;
+    contended = 0;
+    published.reserve(LEADERBOARD_SIZE);
+    merged.reserve(LEADERBOARD_SIZE * shards);
+}
+
+void Leaderboard::report(int id, int score) {
+    Shard& shard = shards[id % shardCount];
+    std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        contended++;
+        lock.lock();
+    }
+    int& playerBest = shard.bests[id];
+    if (score <= playerBest) {
+        return;
+    }
+    playerBest = score;
+    int currentBest = best.load();
+    while (score > currentBest && !best.compare_exchange_weak(currentBest, score)) {
+    }
+
+    //Bests only go up, so the player either moves up the shard's list or joins it.
+    LeaderboardEntry entry = { id, score };
+    std::vector<LeaderboardEntry>& top = shard.top;
+    auto found = std::find_if(top.begin(), top.end(), [id](const LeaderboardEntry& e) { return e.id == id; });
+    if (found != top.end()) {
+        top.erase(found);
+    }
+    else if ((int)top.size() == LEADERBOARD_SIZE) {
+        if (!ranksAbove(entry, top.back())) {
+            return;
+        }
+        top.pop_back();
+    }
+    top.insert(std::upper_bound(top.begin(), top.end(), entry, ranksAbove), entry);
+    changed = true;
+}
+
+int Leaderboard::getBest() {
+    return best.load();
+}
+
+int Leaderboard::getBest(int id) {
+    Shard& shard = shards[id % shardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.bests.find(id);
+    return found == shard.bests.end() ? 0 : found->second;
+}
+
+int64_t Leaderboard::getContended() {
+    return contended.load();
+}
+
+bool Leaderboard::publish(bool full, std::string* message) {
+    //Nothing to merge unless a report changed a shard's list.
+    if (changed.exchange(false)) {
+        merged.clear();
+        for (int i = 0; i < shardCount; i++) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            merged.insert(merged.end(), shards[i].top.begin(), shards[i].top.end());
+        }
+        std::sort(merged.begin(), merged.end(), ranksAbove);
+        merged.resize(std::min((int)merged.size(), LEADERBOARD_SIZE));
+    }
+    else if (!full) {
+        return false;
+    }
+    else {
+        merged = published;
+    }
+
+    //Write the places that differ from what subscribers have.
+    message->clear();
+    char record[48];
+    bool any = false;
+    for (int rank = 0; rank < LEADERBOARD_SIZE; rank++) {
+        bool had = rank < (int)published.size();
+        bool has = rank < (int)merged.size();
+        if (!full && had == has && (!has || (published[rank].id == merged[rank].id && published[rank].score == merged[rank].score))) {
+            continue;
+        }
+        int length = has ? snprintf(record, sizeof(record), "%d %d %d,", rank, merged[rank].id, merged[rank].score)
+            : snprintf(record, sizeof(record), "%d -1 0,", rank);
+        message->append(record, length);
+        any = true;
+    }
+    if (!any && !full) {
+        return false;
+    }
+    published.swap(merged);
+    version++;
+    int length = snprintf(record, sizeof(record), "%lld %d;", (long long)version, full ? 1 : 0);
+    message->insert(0, record, length);
+    return true;
+}
+
+bool Leaderboard::applyUpdate(const char* message, std::vector<LeaderboardEntry>* top, int64_t* version) {
+    long long messageVersion = 0;
+    int full = 0;
+    int used = 0;
+    if (sscanf_s(message, "%lld %d;%n", &messageVersion, &full, &used) != 2 || used == 0) {
+        return false;
+    }
+    //A missed delta leaves us wrong until the next full leaderboard.
+    if (!full && messageVersion != *version + 1) {
+        return false;
+    }
+    if (full) {
+        top->clear();
+    }
+    const char* records = message + used;
+    int rank = 0;
+    LeaderboardEntry entry;
+    int pos = 0;
+    while (sscanf_s(records, "%d %d %d,%n", &rank, &entry.id, &entry.score, &pos) == 3 && pos > 0) {
+        records += pos;
+        pos = 0;
+        if (rank < 0 || rank >= LEADERBOARD_SIZE) {
+            continue;
+        }
+        if ((int)top->size() <= rank) {
+            top->resize(rank + 1, { -1, 0 });
+        }
+        (*top)[rank] = entry;
+    }
+    //Empty places are only ever at the end.
+    while (!top->empty() && top->back().id == -1) {
+        top->pop_back();
+    }
+    *version = messageVersion;
+    return true;
+}
@@ -0,0 +1,120 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Places on the leaderboard.
+#define LEADERBOARD_SIZE 10
+//Tics between full leaderboards, so subscribers that just joined or missed a delta catch up.
+#define LEADERBOARD_FULL_TICS 100
+
+/**
+* One place on the leaderboard.
+*/
+struct LeaderboardEntry {
+    int id;
+    int score;
+};
+
+/**
+* The best score of every player and the LEADERBOARD_SIZE best of them, for the server.
+* Players are split over shards by ID, each with its own lock, its own bests and its own top list. Sessions are
+* spread over RepThreads by ID the same way, so with one shard per RepThread every thread reports into a shard no
+* other reporter touches. A score that doesn't beat the player's best only takes that shard's lock.
+* The overall best is an atomic, so reading it never locks. Only the publisher merges the shards' top lists, and
+* only on tics where one of them changed.
+* What the publisher sends is "version full;rank id score,..." for every place that changed since the last
+* version, or every place if full is 1. An id of -1 means the place is empty. Subscribers use applyUpdate().
+*/
+class Leaderboard {
+private:
+    struct Shard {
+        std::mutex mutex;
+        /**
+        * Best score of every player in the shard.
+        */
+        std::unordered_map<int, int> bests;
+        /**
+        * The shard's best players, best first. At most LEADERBOARD_SIZE.
+        */
+        std::vector<LeaderboardEntry> top;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    int shardCount;
+
+    /**
+    * Best score anyone has had. Never goes down.
+    */
+    std::atomic<int> best;
+
+    /**
+    * Set when a shard's top list changed since the publisher last merged them.
+    */
+    std::atomic<bool> changed;
+
+    /**
+    * Reports that found their shard locked and had to wait.
+    */
+    std::atomic<int64_t> contended;
+
+    //Everything below is only used by the publisher thread.
+
+    /**
+    * The leaderboard as last published, and the one being merged.
+    */
+    std::vector<LeaderboardEntry> published;
+    std::vector<LeaderboardEntry> merged;
+    int64_t version = 0;
+
+public:
+    /**
+    * Create an empty leaderboard split over the given number of shards.
+    */
+    Leaderboard(int shards);
+
+    /**
+    * Record a player's score. Only does anything if it beats their best. Safe to call from any thread.
+    */
+    void report(int id, int score);
+
+    /**
+    * Return the best score anyone has had, at least 1. Doesn't lock.
+    */
+    int getBest();
+
+    /**
+    * Return a player's best score, or 0 if they never reported one.
+    */
+    int getBest(int id);
+
+    /**
+    * Return the number of reports that had to wait for another thread to let go of their shard.
+    */
+    int64_t getContended();
+
+    /**
+    * Build the next message for subscribers. Only call from one thread.
+    * @param full send every place, not just the changed ones.
+    * @param message set to the message, reusing its memory.
+    * @return false if nothing changed and full wasn't asked for. message is left alone then.
+    */
+    bool publish(bool full, std::string* message);
+
+    /**
+    * Apply a message from publish() to a subscriber's copy of the leaderboard. A delta that doesn't follow the
+    * version the copy is at is ignored, and the copy waits for the next full leaderboard.
+    * @param top the copy, best first.
+    * @param version the copy's version. 0 if it has never had a full leaderboard.
+    * @return true if the copy changed.
+    */
+    static bool applyUpdate(const char* message, std::vector<LeaderboardEntry>* top, int64_t* version);
+};
+
+#endif
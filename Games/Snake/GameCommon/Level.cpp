@@ -0,0 +1,104 @@
+#include "Level.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+Level::Level(int columns, int rows, sf::Vector2f origin, float cellSize) : initial(columns, rows, origin, cellSize),
+    bounds(origin.x, origin.y, columns * cellSize, rows * cellSize) {
+}
+
+Level Level::makeClassic() {
+    return makeOpen(39, 29);
+}
+
+Level Level::makeOpen(int columns, int rows) {
+    //Cells start inside a wall as thick as half a cell.
+    float cell = CHAR_SPEED;
+    float wall = cell / 2;
+    float width = columns * cell;
+    float height = rows * cell;
+    Level level(columns, rows, sf::Vector2f(wall, wall), cell);
+    sf::Color wallColor(100, 0, 0);
+    level.addWall(sf::FloatRect(0, wall + height, width + 2 * wall, wall), wallColor);
+    level.addWall(sf::FloatRect(wall + width, wall, wall, height), wallColor);
+    level.addWall(sf::FloatRect(0, wall, wall, height), wallColor);
+    level.addWall(sf::FloatRect(0, 0, width + 2 * wall, wall), wallColor);
+    level.addSpawn(0);
+    return level;
+}
+
+Level Level::parseArena(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "-arena") == 0) {
+            int columns = 0;
+            int rows = 0;
+            int fields = sscanf_s(argv[i + 1], "%dx%d", &columns, &rows);
+            if (fields == 1) {
+                rows = columns;
+            }
+            if (fields >= 1 && columns > 0 && rows > 0 && columns <= MAX_ARENA_SIZE && rows <= MAX_ARENA_SIZE) {
+                return makeOpen(columns, rows);
+            }
+        }
+    }
+    return makeClassic();
+}
+
+void Level::addWall(sf::FloatRect bounds, sf::Color color) {
+    std::shared_ptr<Platform> wall(new Platform);
+    wall->setSize(sf::Vector2f(bounds.width, bounds.height));
+    wall->setFillColor(color);
+    wall->setPosition(sf::Vector2f(bounds.left, bounds.top));
+    walls.push_back(wall);
+    //Grow the level's bounds to take in the wall.
+    float levelRight = std::max(this->bounds.left + this->bounds.width, bounds.left + bounds.width);
+    float levelBottom = std::max(this->bounds.top + this->bounds.height, bounds.top + bounds.height);
+    this->bounds.left = std::min(this->bounds.left, bounds.left);
+    this->bounds.top = std::min(this->bounds.top, bounds.top);
+    this->bounds.width = levelRight - this->bounds.left;
+    this->bounds.height = levelBottom - this->bounds.top;
+
+    //Mark every cell the wall covers. Walls around the outside of the board cover none.
+    sf::Vector2f first = initial.getOrigin();
+    float size = initial.getCellSize();
+    int left = std::max(0, (int)std::floor((bounds.left - first.x) / size));
+    int top = std::max(0, (int)std::floor((bounds.top - first.y) / size));
+    int right = std::min(initial.getColumns(), (int)std::ceil((bounds.left + bounds.width - first.x) / size));
+    int bottom = std::min(initial.getRows(), (int)std::ceil((bounds.top + bounds.height - first.y) / size));
+    for (int row = top; row < bottom; row++) {
+        for (int column = left; column < right; column++) {
+            initial.occupy(row * initial.getColumns() + column, OccupancyGrid::WALL);
+        }
+    }
+}
+
+void Level::addSpawn(int cell) {
+    spawnCells.push_back(cell);
+}
+
+void Level::addTo(World* world) const {
+    for (const std::shared_ptr<Platform>& wall : walls) {
+        world->addGameObject(wall.get());
+    }
+}
+
+OccupancyGrid Level::makeBoard() const {
+    return initial;
+}
+
+void Level::reset(OccupancyGrid* board) const {
+    *board = initial;
+}
+
+int Level::getSpawnCount() const {
+    return (int)spawnCells.size();
+}
+
+sf::FloatRect Level::getBounds() const {
+    return bounds;
+}
+
+sf::Vector2f Level::getSpawnPosition(int i) const {
+    return initial.positionOf(spawnCells[i]);
+}
@@ -0,0 +1,96 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+#include "OccupancyGrid.h"
+#include "Platform.h"
+#include "World.h"
+
+//Largest number of columns or rows an arena can have.
+#define MAX_ARENA_SIZE 16384
+
+/**
+* A board described once: its cells, its walls and where snakes spawn. Built at startup and never changed after,
+* so one Level is shared by every player that plays on it. Resetting a board to the level is one bulk copy into
+* memory the board already has, and the walls are the same Platforms for the whole session.
+*/
+class Level {
+private:
+    /**
+    * The board as it is before anyone plays on it: walls marked, everything else free.
+    */
+    OccupancyGrid initial;
+
+    std::vector<std::shared_ptr<Platform>> walls;
+
+    /**
+    * Cells snakes start in.
+    */
+    std::vector<int> spawnCells;
+
+    /**
+    * The area covered by the board and its walls.
+    */
+    sf::FloatRect bounds;
+
+public:
+    Level(int columns, int rows, sf::Vector2f origin, float cellSize);
+
+    /**
+    * The 39x29 board inside four walls that the game has always been played on, with one spawn in the top left.
+    */
+    static Level makeClassic();
+
+    /**
+    * An empty columns x rows board of segment-sized cells inside four walls, with one spawn in the top left.
+    */
+    static Level makeOpen(int columns, int rows);
+
+    /**
+    * Read the arena size from the command line. "-arena N" is an N x N board and "-arena CxR" is C columns by R
+    * rows, both made with makeOpen(). Without it, or with a size out of range, this is makeClassic().
+    */
+    static Level parseArena(int argc, char** argv);
+
+    /**
+    * Add a wall. Any board cells it covers are marked WALL.
+    */
+    void addWall(sf::FloatRect bounds, sf::Color color);
+
+    /**
+    * Add a cell snakes can start in.
+    */
+    void addSpawn(int cell);
+
+    /**
+    * Add every wall to a world, for drawing.
+    */
+    void addTo(World* world) const;
+
+    /**
+    * Return a new board for this level.
+    */
+    OccupancyGrid makeBoard() const;
+
+    /**
+    * Put a board made by makeBoard() back the way the level starts. Copies into the board's own memory, so it
+    * doesn't allocate.
+    */
+    void reset(OccupancyGrid* board) const;
+
+    int getSpawnCount() const;
+
+    /**
+    * Return the area covered by the board and its walls.
+    */
+    sf::FloatRect getBounds() const;
+
+    /**
+    * Return the board position of spawn i.
+    */
+    sf::Vector2f getSpawnPosition(int i) const;
+};
+
+#endif
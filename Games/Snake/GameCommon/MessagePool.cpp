@@ -0,0 +1,135 @@
+#include "MessagePool.h"
+#include <cstdio>
+#include <cstring>
+
+//Bytes in front of every pooled buffer, holding its size class. Keeps the buffer itself aligned.
+#define POOL_HEADER 16
+
+MessagePool::MessagePool(int preallocate) {
+    allocations = 0;
+    wrapped = 0;
+    for (int i = 0; i < preallocate; i++) {
+        char* block = new char[POOL_HEADER + POOL_BUFFER_SIZE];
+        block[0] = 0;
+        freeBuffers[0].push_back(block + POOL_HEADER);
+        allocations++;
+    }
+}
+
+MessagePool::~MessagePool() {
+    for (int c = 0; c < POOL_CLASSES; c++) {
+        for (char* buffer : freeBuffers[c]) {
+            delete[] (buffer - POOL_HEADER);
+        }
+    }
+}
+
+int MessagePool::sizeClass(size_t size) {
+    int c = 0;
+    while (c < POOL_CLASSES && size > classSize(c)) {
+        c++;
+    }
+    return c;
+}
+
+size_t MessagePool::classSize(int sizeClass) {
+    size_t size = POOL_BUFFER_SIZE;
+    for (int c = 0; c < sizeClass; c++) {
+        size *= POOL_CLASS_STEP;
+    }
+    return size;
+}
+
+char* MessagePool::acquire(size_t size) {
+    int c = sizeClass(size);
+    if (c == POOL_CLASSES) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeBuffers[c].empty()) {
+            char* buffer = freeBuffers[c].back();
+            freeBuffers[c].pop_back();
+            return buffer;
+        }
+    }
+    allocations++;
+    char* block = new char[POOL_HEADER + classSize(c)];
+    block[0] = (char)c;
+    return block + POOL_HEADER;
+}
+
+void MessagePool::wrap(zmq::message_t* message, char* buffer, size_t length) {
+    wrapped++;
+    message->rebuild(buffer, length, release, this);
+}
+
+void MessagePool::giveBack(char* buffer) {
+    release(buffer, this);
+}
+
+void MessagePool::release(void* data, void* hint) {
+    MessagePool* pool = (MessagePool*)hint;
+    char* buffer = (char*)data;
+    int c = buffer[-POOL_HEADER];
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->freeBuffers[c].push_back(buffer);
+}
+
+void MessagePool::format(zmq::message_t* message, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    char small[INLINE_MESSAGE_SIZE];
+    int length = vsnprintf(small, INLINE_MESSAGE_SIZE, format, args);
+    va_end(args);
+    if (length < 0) {
+        length = 0;
+        small[0] = '\0';
+    }
+
+    //Fits inline, zmq copies it into the message itself.
+    if (length + 1 <= INLINE_MESSAGE_SIZE) {
+        message->rebuild(small, length + 1);
+        return;
+    }
+
+    char* buffer = acquire(length + 1);
+    //Too big for any pooled buffer. Let zmq allocate it.
+    if (buffer == nullptr) {
+        allocations++;
+        message->rebuild(length + 1);
+        va_start(args, format);
+        vsnprintf((char*)message->data(), length + 1, format, args);
+        va_end(args);
+        return;
+    }
+
+    va_start(args, format);
+    vsnprintf(buffer, length + 1, format, args);
+    va_end(args);
+    wrap(message, buffer, length + 1);
+}
+
+void MessagePool::copy(zmq::message_t* message, const std::string& string) {
+    size_t length = string.size() + 1;
+    if (length <= INLINE_MESSAGE_SIZE) {
+        message->rebuild(string.c_str(), length);
+        return;
+    }
+    char* buffer = acquire(length);
+    if (buffer == nullptr) {
+        allocations++;
+        message->rebuild(string.c_str(), length);
+        return;
+    }
+    memcpy(buffer, string.c_str(), length);
+    wrap(message, buffer, length);
+}
+
+int64_t MessagePool::getAllocations() {
+    return allocations;
+}
+
+int64_t MessagePool::getWrapped() {
+    return wrapped;
+}
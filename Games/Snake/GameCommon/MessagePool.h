@@ -0,0 +1,111 @@
+#ifndef MESSAGEPOOL_H
+#define MESSAGEPOOL_H
+
+#include <zmq.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdarg>
+
+//zmq keeps messages up to this size inside the message_t itself, so they never touch the heap.
+#define INLINE_MESSAGE_SIZE 33
+//Size of the smallest pooled buffer.
+#define POOL_BUFFER_SIZE 1024
+//Pooled buffers come in POOL_CLASSES sizes, each POOL_CLASS_STEP times the one before: 1 KB, 16 KB, 256 KB and 4 MB.
+#define POOL_CLASSES 4
+#define POOL_CLASS_STEP 16
+
+/**
+* Builds outgoing zmq messages without a stringstream, a temporary string or a fresh heap buffer per send.
+* Short messages (most of the protocol) are written into zmq's inline storage and never touch the heap.
+* Longer ones are written straight into a buffer taken from the pool, in the smallest size class that fits, and
+* handed to zmq with zmq_msg_init_data. zmq gives the buffer back through release() when it is done with it, which
+* may happen on another thread. zmq_msg_init_data still allocates zmq's small reference count for every such
+* message, so a pooled send costs one small allocation instead of a payload-sized allocation and a copy.
+* Messages bigger than the largest class are left to zmq.
+*/
+class MessagePool {
+private:
+    /**
+    * Buffers that are free to use, by size class.
+    */
+    std::vector<char*> freeBuffers[POOL_CLASSES];
+
+    /**
+    * Protects freeBuffers. Buffers come back from zmq's threads as well as ours.
+    */
+    std::mutex mutex;
+
+    /**
+    * Heap allocations made by the pool: new buffers, and messages too big for a buffer.
+    */
+    std::atomic<int64_t> allocations;
+
+    /**
+    * Messages handed to zmq in a pooled buffer. zmq allocates its reference count for each one.
+    */
+    std::atomic<int64_t> wrapped;
+
+    /**
+    * Return the smallest size class holding size bytes, or POOL_CLASSES if none does.
+    */
+    static int sizeClass(size_t size);
+
+    /**
+    * Return the size of the buffers in a size class.
+    */
+    static size_t classSize(int sizeClass);
+
+    /**
+    * zmq free callback. hint is the pool the buffer came from.
+    */
+    static void release(void* data, void* hint);
+
+public:
+    /**
+    * Create a pool with some of the smallest buffers ready to go. Bigger ones are made the first time they are needed.
+    */
+    MessagePool(int preallocate = 16);
+
+    ~MessagePool();
+
+    /**
+    * printf into message, replacing whatever it held. The terminating null is sent too, like every other message.
+    */
+    void format(zmq::message_t* message, const char* format, ...);
+
+    /**
+    * Copy a string (and its terminating null) into message, replacing whatever it held.
+    */
+    void copy(zmq::message_t* message, const std::string& string);
+
+    /**
+    * Take a free buffer of at least size bytes to write a message into yourself, allocating one only if none are
+    * left. Returns nullptr if size is bigger than the largest class. Hand it to a message with wrap().
+    */
+    char* acquire(size_t size = POOL_BUFFER_SIZE);
+
+    /**
+    * Make message send the first length bytes of a buffer from acquire(). The buffer goes back to the pool
+    * when zmq is done with it.
+    */
+    void wrap(zmq::message_t* message, char* buffer, size_t length);
+
+    /**
+    * Put a buffer from acquire() back without sending it.
+    */
+    void giveBack(char* buffer);
+
+    /**
+    * Return the number of heap allocations the pool has made, including messages too big for any buffer.
+    */
+    int64_t getAllocations();
+
+    /**
+    * Return the number of messages sent in a pooled buffer.
+    */
+    int64_t getWrapped();
+};
+
+#endif
@@ -15,6 +15,7 @@
         bound1 = 0;
         bound2 = 0;
 
+        std::lock_guard<std::mutex> lock(GameObject::innerMutex);
         guid = "moving" + std::to_string(*GameObject::getCurrentGUID());
         (*GameObject::getCurrentGUID())++;
         game_objects.push_back(this);
@@ -25,6 +26,7 @@
         bound2 = 0;
         m_type = 0;
 
+        std::lock_guard<std::mutex> lock(GameObject::innerMutex);
         guid = "moving" + std::to_string(*GameObject::getCurrentGUID());
         (*GameObject::getCurrentGUID())++;
         game_objects.push_back(this);
@@ -0,0 +1,302 @@
+#include "OccupancyGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+OccupancyGrid::OccupancyGrid(int columns, int rows, sf::Vector2f origin, float cellSize) {
+    this->columns = columns;
+    this->rows = rows;
+    this->origin = origin;
+    this->cellSize = cellSize;
+    chunkColumns = (columns + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkRows = (rows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunks.resize(chunkColumns * chunkRows);
+    rowUsed.resize(chunkRows, 0);
+}
+
+bool OccupancyGrid::onBoard(int cell) const {
+    return cell >= 0 && cell < columns * rows;
+}
+
+void OccupancyGrid::locate(int cell, int* chunk, int* offset) const {
+    int row = cell / columns;
+    int column = cell - row * columns;
+    *chunk = (row / CHUNK_SIZE) * chunkColumns + column / CHUNK_SIZE;
+    *offset = (row % CHUNK_SIZE) * CHUNK_SIZE + column % CHUNK_SIZE;
+}
+
+int OccupancyGrid::cellIn(int chunk, int offset) const {
+    int column = (chunk % chunkColumns) * CHUNK_SIZE + offset % CHUNK_SIZE;
+    int row = (chunk / chunkColumns) * CHUNK_SIZE + offset / CHUNK_SIZE;
+    return row * columns + column;
+}
+
+int OccupancyGrid::chunkWidth(int chunk) const {
+    return std::min(CHUNK_SIZE, columns - (chunk % chunkColumns) * CHUNK_SIZE);
+}
+
+int OccupancyGrid::chunkHeight(int chunk) const {
+    return std::min(CHUNK_SIZE, rows - (chunk / chunkColumns) * CHUNK_SIZE);
+}
+
+void OccupancyGrid::materialize(int chunk) {
+    Chunk& piece = chunks[chunk];
+    piece.contents.assign(CHUNK_CELLS, EMPTY);
+    piece.occupied.assign(CHUNK_CELLS / 64, 0);
+    piece.freeAt.assign(CHUNK_CELLS, 0);
+    piece.freeCells.clear();
+    piece.freeCells.reserve(CHUNK_CELLS);
+    piece.used = 0;
+    //Cells past the edge of the board are never free.
+    int width = chunkWidth(chunk);
+    int height = chunkHeight(chunk);
+    for (int row = 0; row < CHUNK_SIZE; row++) {
+        for (int column = 0; column < CHUNK_SIZE; column++) {
+            int offset = row * CHUNK_SIZE + column;
+            if (row < height && column < width) {
+                piece.freeAt[offset] = (uint16_t)piece.freeCells.size();
+                piece.freeCells.push_back((uint16_t)offset);
+            }
+            else {
+                piece.occupied[offset / 64] |= (uint64_t)1 << (offset % 64);
+            }
+        }
+    }
+}
+
+void OccupancyGrid::reset() {
+    for (Chunk& piece : chunks) {
+        piece.contents.clear();
+        piece.occupied.clear();
+        piece.freeCells.clear();
+        piece.freeAt.clear();
+        piece.used = 0;
+    }
+    std::fill(rowUsed.begin(), rowUsed.end(), 0);
+}
+
+void OccupancyGrid::trim() {
+    for (Chunk& piece : chunks) {
+        if (piece.used == 0) {
+            std::vector<uint8_t>().swap(piece.contents);
+            std::vector<uint64_t>().swap(piece.occupied);
+            std::vector<uint16_t>().swap(piece.freeCells);
+            std::vector<uint16_t>().swap(piece.freeAt);
+        }
+    }
+}
+
+void OccupancyGrid::occupy(int cell, CONTENT content) {
+    if (!onBoard(cell)) {
+        return;
+    }
+    int chunk;
+    int offset;
+    locate(cell, &chunk, &offset);
+    Chunk& piece = chunks[chunk];
+    if (piece.contents.empty()) {
+        materialize(chunk);
+    }
+    piece.contents[offset] = content;
+    uint64_t bit = (uint64_t)1 << (offset % 64);
+    if ((piece.occupied[offset / 64] & bit) == 0) {
+        piece.occupied[offset / 64] |= bit;
+        //Move the last free cell into the one taken.
+        uint16_t last = piece.freeCells.back();
+        piece.freeCells[piece.freeAt[offset]] = last;
+        piece.freeAt[last] = piece.freeAt[offset];
+        piece.freeCells.pop_back();
+        piece.used++;
+        rowUsed[chunk / chunkColumns]++;
+    }
+}
+
+void OccupancyGrid::release(int cell) {
+    if (!onBoard(cell)) {
+        return;
+    }
+    int chunk;
+    int offset;
+    locate(cell, &chunk, &offset);
+    Chunk& piece = chunks[chunk];
+    if (piece.contents.empty() || ((piece.occupied[offset / 64] >> (offset % 64)) & 1) == 0) {
+        return;
+    }
+    //The chunk keeps its memory even when this empties it, so a snake going back and forth doesn't allocate.
+    piece.occupied[offset / 64] &= ~((uint64_t)1 << (offset % 64));
+    piece.contents[offset] = EMPTY;
+    piece.freeAt[offset] = (uint16_t)piece.freeCells.size();
+    piece.freeCells.push_back((uint16_t)offset);
+    piece.used--;
+    rowUsed[chunk / chunkColumns]--;
+}
+
+bool OccupancyGrid::isOccupied(int cell) const {
+    if (!onBoard(cell)) {
+        return true;
+    }
+    int chunk;
+    int offset;
+    locate(cell, &chunk, &offset);
+    const Chunk& piece = chunks[chunk];
+    if (piece.contents.empty()) {
+        return false;
+    }
+    return (piece.occupied[offset / 64] >> (offset % 64)) & 1;
+}
+
+OccupancyGrid::CONTENT OccupancyGrid::contentAt(int cell) const {
+    if (!onBoard(cell)) {
+        return WALL;
+    }
+    int chunk;
+    int offset;
+    locate(cell, &chunk, &offset);
+    const Chunk& piece = chunks[chunk];
+    if (piece.contents.empty()) {
+        return EMPTY;
+    }
+    return (CONTENT)piece.contents[offset];
+}
+
+template <typename Generator> int OccupancyGrid::pickFree(Generator next, int firstChunkRow, int lastChunkRow) {
+    int free = freeCount(firstChunkRow, lastChunkRow);
+    if (free == 0) {
+        return -1;
+    }
+    //Count down to the k-th free cell: skip whole rows of chunks, then whole chunks, then read it off the free list.
+    int k = (int)(next() % (unsigned int)free);
+    for (int chunkRow = firstChunkRow; chunkRow < lastChunkRow; chunkRow++) {
+        int rowFree = freeCount(chunkRow, chunkRow + 1);
+        if (k >= rowFree) {
+            k -= rowFree;
+            continue;
+        }
+        for (int chunk = chunkRow * chunkColumns; chunk < (chunkRow + 1) * chunkColumns; chunk++) {
+            const Chunk& piece = chunks[chunk];
+            int width = chunkWidth(chunk);
+            int chunkFree = width * chunkHeight(chunk) - piece.used;
+            if (k >= chunkFree) {
+                k -= chunkFree;
+                continue;
+            }
+            if (piece.contents.empty()) {
+                return cellIn(chunk, (k / width) * CHUNK_SIZE + k % width);
+            }
+            return cellIn(chunk, piece.freeCells[k]);
+        }
+    }
+    return -1;
+}
+
+int OccupancyGrid::randomFree() {
+    //rand() can be as small as 15 bits, too few for a big board.
+    return pickFree([]() { return ((unsigned int)rand() << 15) ^ (unsigned int)rand(); }, 0, chunkRows);
+}
+
+int OccupancyGrid::randomFree(std::mt19937* random) {
+    return pickFree([random]() { return (unsigned int)(*random)(); }, 0, chunkRows);
+}
+
+int OccupancyGrid::randomFree(std::mt19937* random, int firstChunkRow, int lastChunkRow) {
+    return pickFree([random]() { return (unsigned int)(*random)(); }, firstChunkRow, lastChunkRow);
+}
+
+int OccupancyGrid::freeCount() const {
+    return freeCount(0, chunkRows);
+}
+
+int OccupancyGrid::freeCount(int firstChunkRow, int lastChunkRow) const {
+    int occupied = 0;
+    for (int row = firstChunkRow; row < lastChunkRow; row++) {
+        occupied += rowUsed[row];
+    }
+    return columns * (std::min(rows, lastChunkRow * CHUNK_SIZE) - firstChunkRow * CHUNK_SIZE) - occupied;
+}
+
+int OccupancyGrid::cellAt(sf::Vector2f position) const {
+    int column = (int)std::floor((position.x - origin.x) / cellSize);
+    int row = (int)std::floor((position.y - origin.y) / cellSize);
+    if (column < 0 || column >= columns || row < 0 || row >= rows) {
+        return -1;
+    }
+    return row * columns + column;
+}
+
+int OccupancyGrid::neighbor(int cell, int dx, int dy) const {
+    int column = cell % columns + dx;
+    int row = cell / columns + dy;
+    if (cell < 0 || column < 0 || column >= columns || row < 0 || row >= rows) {
+        return -1;
+    }
+    return row * columns + column;
+}
+
+sf::Vector2f OccupancyGrid::positionOf(int cell) const {
+    return sf::Vector2f(origin.x + (cell % columns) * cellSize, origin.y + (cell / columns) * cellSize);
+}
+
+void OccupancyGrid::cellsIn(sf::FloatRect area, CONTENT content, std::vector<int>* cells) const {
+    int left = std::max(0, (int)std::floor((area.left - origin.x) / cellSize));
+    int top = std::max(0, (int)std::floor((area.top - origin.y) / cellSize));
+    int right = std::min(columns, (int)std::ceil((area.left + area.width - origin.x) / cellSize));
+    int bottom = std::min(rows, (int)std::ceil((area.top + area.height - origin.y) / cellSize));
+    if (left >= right || top >= bottom) {
+        return;
+    }
+    for (int chunkRow = top / CHUNK_SIZE; chunkRow <= (bottom - 1) / CHUNK_SIZE; chunkRow++) {
+        for (int chunkColumn = left / CHUNK_SIZE; chunkColumn <= (right - 1) / CHUNK_SIZE; chunkColumn++) {
+            const Chunk& piece = chunks[chunkRow * chunkColumns + chunkColumn];
+            if (piece.used == 0) {
+                continue;
+            }
+            //The part of the area inside this chunk.
+            int firstRow = std::max(top, chunkRow * CHUNK_SIZE);
+            int lastRow = std::min(bottom, (chunkRow + 1) * CHUNK_SIZE);
+            int firstColumn = std::max(left, chunkColumn * CHUNK_SIZE);
+            int lastColumn = std::min(right, (chunkColumn + 1) * CHUNK_SIZE);
+            for (int row = firstRow; row < lastRow; row++) {
+                const uint8_t* line = &piece.contents[(row % CHUNK_SIZE) * CHUNK_SIZE];
+                for (int column = firstColumn; column < lastColumn; column++) {
+                    if (line[column % CHUNK_SIZE] == content) {
+                        cells->push_back(row * columns + column);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int OccupancyGrid::getMaterializedChunks() const {
+    int count = 0;
+    for (const Chunk& piece : chunks) {
+        if (piece.contents.capacity() != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int OccupancyGrid::getChunkCount() const {
+    return (int)chunks.size();
+}
+
+int OccupancyGrid::getChunkRows() const {
+    return chunkRows;
+}
+
+int OccupancyGrid::getColumns() const {
+    return columns;
+}
+
+int OccupancyGrid::getRows() const {
+    return rows;
+}
+
+sf::Vector2f OccupancyGrid::getOrigin() const {
+    return origin;
+}
+
+float OccupancyGrid::getCellSize() const {
+    return cellSize;
+}
@@ -0,0 +1,214 @@
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+//Cells along each side of a chunk of the board. A power of two so the bits of a chunk row fill whole words.
+#define CHUNK_SIZE 64
+#define CHUNK_CELLS (CHUNK_SIZE * CHUNK_SIZE)
+
+/**
+* Which cells of the board something is standing in, and what it is. Cells are numbered row by row from the top left.
+* The board is stored in CHUNK_SIZE x CHUNK_SIZE chunks, and a chunk only gets memory once something is put in it,
+* so a 4096x4096 arena with a few hundred snakes costs what the snakes cover, not 16 million cells. Each chunk keeps
+* what is in its cells, a bitset of which are occupied and a list of its free cells. occupy(), release() and
+* contentAt() are O(1), so moving into a cell is resolved with one lookup instead of a collision query.
+* Not thread safe, except that threads that each keep to their own rows of chunks can change the board at once:
+* nothing is shared between chunk rows.
+*/
+class OccupancyGrid {
+public:
+    /**
+    * What can be in a cell. Everything off the board counts as WALL.
+    */
+    enum CONTENT {
+        EMPTY,
+        WALL,
+        BODY,
+        APPLE,
+        SNAKE
+    };
+
+private:
+    /**
+    * One CHUNK_SIZE x CHUNK_SIZE piece of the board. The vectors are empty until something is put in the chunk.
+    * Cells of an edge chunk that are off the board are set in occupied, so they are never picked as free.
+    */
+    struct Chunk {
+        std::vector<uint8_t> contents;
+        std::vector<uint64_t> occupied;
+        /**
+        * The free cells on the board, as offsets in no particular order, and where each free offset is in freeCells.
+        * Taking a cell moves the last one into its place, so both stay the same size and never allocate.
+        */
+        std::vector<uint16_t> freeCells;
+        std::vector<uint16_t> freeAt;
+        /**
+        * Occupied cells that are on the board.
+        */
+        int used = 0;
+    };
+
+    int columns;
+    int rows;
+
+    /**
+    * Board position of the top left corner of cell 0, and the size of a cell.
+    */
+    sf::Vector2f origin;
+    float cellSize;
+
+    /**
+    * Chunks per row and per column of the board, and the chunks row by row.
+    */
+    int chunkColumns;
+    int chunkRows;
+    std::vector<Chunk> chunks;
+
+    /**
+    * Occupied cells in each row of chunks.
+    */
+    std::vector<int> rowUsed;
+
+    /**
+    * Return true if cell is on the board. -1, and anything past the last cell, isn't.
+    */
+    bool onBoard(int cell) const;
+
+    /**
+    * Find the chunk a cell is in and where it is inside that chunk.
+    */
+    void locate(int cell, int* chunk, int* offset) const;
+
+    /**
+    * Return the cell at an offset inside a chunk.
+    */
+    int cellIn(int chunk, int offset) const;
+
+    /**
+    * Return the number of columns and rows of a chunk that are on the board.
+    */
+    int chunkWidth(int chunk) const;
+    int chunkHeight(int chunk) const;
+
+    /**
+    * Give a chunk its cells, all free. Reuses memory the chunk had before if there is any.
+    */
+    void materialize(int chunk);
+
+    /**
+    * randomFree() with any source of random 32 bit numbers, in rows of chunks [firstChunkRow, lastChunkRow).
+    */
+    template <typename Generator> int pickFree(Generator next, int firstChunkRow, int lastChunkRow);
+
+public:
+    /**
+    * Create a grid with every cell free.
+    */
+    OccupancyGrid(int columns, int rows, sf::Vector2f origin, float cellSize);
+
+    /**
+    * Free every cell. Chunks keep their memory for the next game, trim() gives it back.
+    */
+    void reset();
+
+    /**
+    * Give back the memory of every chunk with nothing in it.
+    */
+    void trim();
+
+    /**
+    * Put something in a cell. Replaces whatever was there. Does nothing if cell is off the board, like -1.
+    */
+    void occupy(int cell, CONTENT content = BODY);
+
+    /**
+    * Mark a cell as free. Does nothing if it already is, or if cell is off the board.
+    */
+    void release(int cell);
+
+    /**
+    * Return true if something is in a cell. Cells off the board are, since they count as WALL.
+    */
+    bool isOccupied(int cell) const;
+
+    /**
+    * Return what is in a cell. Cells off the board, like -1, are WALL.
+    */
+    CONTENT contentAt(int cell) const;
+
+    /**
+    * Return a free cell picked uniformly at random with rand(), or -1 if the board is full. The free cells are
+    * counted a row of chunks at a time and then a chunk at a time, and inside the chunk the cell is read straight
+    * from its free list. That is one look at each chunk row and at each chunk of one row (at most 128 on a
+    * 4096x4096 board) and O(1) on a board of one chunk, however full the board is.
+    */
+    int randomFree();
+
+    /**
+    * Same, but picked with the given generator so a simulation can be replayed from its seed.
+    */
+    int randomFree(std::mt19937* random);
+
+    /**
+    * Same, but only in rows of chunks [firstChunkRow, lastChunkRow), and only looking at those rows.
+    */
+    int randomFree(std::mt19937* random, int firstChunkRow, int lastChunkRow);
+
+    /**
+    * Return the number of free cells.
+    */
+    int freeCount() const;
+
+    /**
+    * Return the number of free cells in rows of chunks [firstChunkRow, lastChunkRow).
+    */
+    int freeCount(int firstChunkRow, int lastChunkRow) const;
+
+    /**
+    * Return the cell a board position is in, or -1 if it is off the board.
+    */
+    int cellAt(sf::Vector2f position) const;
+
+    /**
+    * Return the cell next to cell, dx columns and dy rows away, or -1 if that is off the board.
+    */
+    int neighbor(int cell, int dx, int dy) const;
+
+    /**
+    * Return the board position of a cell's top left corner.
+    */
+    sf::Vector2f positionOf(int cell) const;
+
+    /**
+    * Append every cell holding content that is at least partly inside a board area, like the part of the board in
+    * view. Chunks nothing has been put in are skipped without looking at their cells, so the cost is the area's
+    * cells at most, however big the board is.
+    */
+    void cellsIn(sf::FloatRect area, CONTENT content, std::vector<int>* cells) const;
+
+    /**
+    * Return the number of chunks that have memory, and the number of chunks on the board.
+    */
+    int getMaterializedChunks() const;
+
+    int getChunkCount() const;
+
+    /**
+    * Return the number of rows of chunks. Cell rows [i * CHUNK_SIZE, (i + 1) * CHUNK_SIZE) are chunk row i.
+    */
+    int getChunkRows() const;
+
+    int getColumns() const;
+
+    int getRows() const;
+
+    sf::Vector2f getOrigin() const;
+
+    float getCellSize() const;
+};
+
+#endif
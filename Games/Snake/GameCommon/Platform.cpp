@@ -1,6 +1,7 @@
 #include "Platform.h"
 
 Platform::Platform() : sf::RectangleShape(), GameObject(true, true, true) {
+    std::lock_guard<std::mutex> lock(GameObject::innerMutex);
     guid = "platform" + std::to_string(*GameObject::getCurrentGUID());
     (*GameObject::getCurrentGUID())++;
     game_objects.push_back(this);
@@ -10,6 +11,7 @@ Platform::Platform(bool stationary, bool collidable, bool drawable) : sf::Rectan
 {
     passthrough = false;
 
+    std::lock_guard<std::mutex> lock(GameObject::innerMutex);
     guid = "platform" + std::to_string(*GameObject::getCurrentGUID());
     (*GameObject::getCurrentGUID())++;
     game_objects.push_back(this);
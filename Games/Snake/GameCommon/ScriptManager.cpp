@@ -1,9 +1,9 @@
 #include "ScriptManager.h"
 
 /** Definition of static container */
-std::map<std::string, ContextContainer> ScriptManager::context_containers;
+thread_local std::map<std::string, ContextContainer> ScriptManager::context_containers;
 
-std::queue<GameObject*> ScriptManager::scriptArgs;
+thread_local std::queue<GameObject*> ScriptManager::scriptArgs;
 
 /** Note: function signature is very important */
 ScriptManager::ScriptManager(v8::Isolate* isolate, v8::Local<v8::Context>& context)
@@ -44,10 +44,14 @@ struct ContextContainer
 class ScriptManager
 {
 private:
-	/** map to keeping track of context information */
-	static std::map<std::string, ContextContainer> context_containers;
+	/**
+	 * map to keeping track of context information. An isolate only ever runs on the thread that made it,
+	 * so each thread keeps its own containers. This lets the server and clients share a process.
+	 */
+	static thread_local std::map<std::string, ContextContainer> context_containers;
 
-	static std::queue<GameObject*> scriptArgs;
+	/** Arguments waiting to be picked up by moreArgs(). Per thread for the same reason as above. */
+	static thread_local std::queue<GameObject*> scriptArgs;
 
 public:
 	/**
@@ -23,7 +23,7 @@ void SideBound::setView(sf::View view)
 
 void SideBound::onCollision()
 {
-	window->setView(view);
+	window->requestView(view);
 }
 
 std::string SideBound::toString()
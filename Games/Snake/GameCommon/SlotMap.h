@@ -0,0 +1,124 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* Refers to a value in a SlotMap. Stays valid until that value is removed, and never points at a value added
+* later in the same slot: every reuse of a slot bumps its generation.
+*/
+struct SlotHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const SlotHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const SlotHandle& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+* Values kept packed in one array, with O(1) insert, remove and lookup through handles.
+* Removing swaps the last value into the hole, so iteration order isn't insertion order, but it is always a
+* straight walk over contiguous memory.
+*/
+template <class T>
+class SlotMap {
+private:
+    struct Slot {
+        /**
+        * Where the value is in values. Unused while the slot is free.
+        */
+        uint32_t dense;
+        uint32_t generation;
+    };
+
+    std::vector<T> values;
+
+    /**
+    * The slot of each value, so the value moved by a remove can be found.
+    */
+    std::vector<uint32_t> owners;
+
+    std::vector<Slot> slots;
+
+    std::vector<uint32_t> freeSlots;
+
+public:
+    SlotHandle insert(const T& value) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            index = (uint32_t)slots.size();
+            slots.push_back({ 0, 0 });
+        }
+        slots[index].dense = (uint32_t)values.size();
+        values.push_back(value);
+        owners.push_back(index);
+        return { index, slots[index].generation };
+    }
+
+    /**
+    * Return the value, or nullptr if the handle is stale.
+    */
+    T* get(SlotHandle handle) {
+        if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) {
+            return nullptr;
+        }
+        return &values[slots[handle.index].dense];
+    }
+
+    /**
+    * Remove the value. Returns false if the handle was already stale.
+    */
+    bool remove(SlotHandle handle) {
+        if (get(handle) == nullptr) {
+            return false;
+        }
+        Slot& slot = slots[handle.index];
+        uint32_t last = (uint32_t)values.size() - 1;
+        if (slot.dense != last) {
+            values[slot.dense] = values[last];
+            owners[slot.dense] = owners[last];
+            slots[owners[slot.dense]].dense = slot.dense;
+        }
+        values.pop_back();
+        owners.pop_back();
+        slot.generation++;
+        freeSlots.push_back(handle.index);
+        return true;
+    }
+
+    /**
+    * Remove every value. Every handle given out so far goes stale.
+    */
+    void clear() {
+        for (uint32_t index : owners) {
+            slots[index].generation++;
+            freeSlots.push_back(index);
+        }
+        values.clear();
+        owners.clear();
+    }
+
+    size_t size() const {
+        return values.size();
+    }
+
+    typename std::vector<T>::iterator begin() {
+        return values.begin();
+    }
+
+    typename std::vector<T>::iterator end() {
+        return values.end();
+    }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "SnakeBody.h"
+
+void SnakeBody::grow() {
+    std::vector<int> bigger(cells.empty() ? 16 : cells.size() * 2);
+    for (int i = 0; i < length; i++) {
+        bigger[i] = at(i);
+    }
+    cells.swap(bigger);
+    head = 0;
+}
+
+void SnakeBody::reserve(int capacity) {
+    while ((int)cells.size() < capacity) {
+        grow();
+    }
+}
+
+void SnakeBody::pushFront(int cell) {
+    if (length == (int)cells.size()) {
+        grow();
+    }
+    head = (head + (int)cells.size() - 1) % (int)cells.size();
+    cells[head] = cell;
+    length++;
+}
+
+int SnakeBody::popBack() {
+    if (length == 0) {
+        return -1;
+    }
+    int cell = back();
+    length--;
+    return cell;
+}
+
+int SnakeBody::back() const {
+    if (length == 0) {
+        return -1;
+    }
+    return at(length - 1);
+}
+
+int SnakeBody::at(int i) const {
+    return cells[(head + i) % cells.size()];
+}
+
+int SnakeBody::size() const {
+    return length;
+}
+
+void SnakeBody::clear() {
+    head = 0;
+    length = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef SNAKEBODY_H
+#define SNAKEBODY_H
+
+#include <vector>
+
+/**
+* The segments trailing behind a snake's head, as the board cells they are in (see OccupancyGrid), front first.
+* Kept in a ring buffer, so moving (pushFront() and popBack()) and growing are O(1) and never allocate once the
+* buffer has room for the whole board. Segments aren't GameObjects: they are drawn with one shared shape and
+* collided by looking their cells up in the board.
+*/
+class SnakeBody {
+private:
+    std::vector<int> cells;
+
+    /**
+    * Where the front segment is in cells.
+    */
+    int head = 0;
+
+    int length = 0;
+
+    /**
+    * Double the buffer, unrolling the ring so the front is at 0 again.
+    */
+    void grow();
+
+public:
+    /**
+    * Make room for capacity segments up front. Call with the number of cells on the board.
+    */
+    void reserve(int capacity);
+
+    /**
+    * Add a segment in front of the others.
+    */
+    void pushFront(int cell);
+
+    /**
+    * Remove the last segment.
+    * @return the cell it was in, or -1 if there are no segments.
+    */
+    int popBack();
+
+    /**
+    * Return the cell of the last segment, or -1 if there are no segments.
+    */
+    int back() const;
+
+    /**
+    * Return the cell of segment i, counting from the front.
+    */
+    int at(int i) const;
+
+    /**
+    * Return the number of segments.
+    */
+    int size() const;
+
+    /**
+    * Remove every segment. Keeps the buffer.
+    */
+    void clear();
+};
+
+#endif
@@ -0,0 +1,434 @@
+#include "SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+//MSVC compiles AVX intrinsics in any function, we only call them when the CPU has them.
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+/**
+* Find the earliest object in a cell (order below bestOrder) that overlaps the query box.
+* q is left, top, right, bottom. Returns the index in the cell, or -1.
+*/
+typedef int (*CellKernel)(const SpatialHash::Cell& cell, const float* q, uint64_t bestOrder);
+
+static int scalarKernel(const SpatialHash::Cell& cell, const float* q, uint64_t bestOrder) {
+    int best = -1;
+    size_t count = cell.objects.size();
+    for (size_t i = 0; i < count; i++) {
+        if (cell.left[i] < q[2] && q[0] < cell.right[i] && cell.top[i] < q[3] && q[1] < cell.bottom[i] && cell.order[i] < bestOrder) {
+            best = (int)i;
+            bestOrder = cell.order[i];
+        }
+    }
+    return best;
+}
+
+#ifdef SIMD_X86
+static int sseKernel(const SpatialHash::Cell& cell, const float* q, uint64_t bestOrder) {
+    int best = -1;
+    size_t count = cell.objects.size();
+    __m128 qLeft = _mm_set1_ps(q[0]);
+    __m128 qTop = _mm_set1_ps(q[1]);
+    __m128 qRight = _mm_set1_ps(q[2]);
+    __m128 qBottom = _mm_set1_ps(q[3]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(&cell.left[i]), qRight), _mm_cmplt_ps(qLeft, _mm_loadu_ps(&cell.right[i])));
+        __m128 y = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(&cell.top[i]), qBottom), _mm_cmplt_ps(qTop, _mm_loadu_ps(&cell.bottom[i])));
+        int mask = _mm_movemask_ps(_mm_and_ps(x, y));
+        //Hits are rare, so this is usually skipped.
+        for (int bit = 0; mask != 0; bit++, mask >>= 1) {
+            if ((mask & 1) && cell.order[i + bit] < bestOrder) {
+                best = (int)(i + bit);
+                bestOrder = cell.order[i + bit];
+            }
+        }
+    }
+    for (; i < count; i++) {
+        if (cell.left[i] < q[2] && q[0] < cell.right[i] && cell.top[i] < q[3] && q[1] < cell.bottom[i] && cell.order[i] < bestOrder) {
+            best = (int)i;
+            bestOrder = cell.order[i];
+        }
+    }
+    return best;
+}
+
+AVX2_TARGET static int avx2Kernel(const SpatialHash::Cell& cell, const float* q, uint64_t bestOrder) {
+    int best = -1;
+    size_t count = cell.objects.size();
+    __m256 qLeft = _mm256_set1_ps(q[0]);
+    __m256 qTop = _mm256_set1_ps(q[1]);
+    __m256 qRight = _mm256_set1_ps(q[2]);
+    __m256 qBottom = _mm256_set1_ps(q[3]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&cell.left[i]), qRight, _CMP_LT_OQ),
+            _mm256_cmp_ps(qLeft, _mm256_loadu_ps(&cell.right[i]), _CMP_LT_OQ));
+        __m256 y = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&cell.top[i]), qBottom, _CMP_LT_OQ),
+            _mm256_cmp_ps(qTop, _mm256_loadu_ps(&cell.bottom[i]), _CMP_LT_OQ));
+        int mask = _mm256_movemask_ps(_mm256_and_ps(x, y));
+        for (int bit = 0; mask != 0; bit++, mask >>= 1) {
+            if ((mask & 1) && cell.order[i + bit] < bestOrder) {
+                best = (int)(i + bit);
+                bestOrder = cell.order[i + bit];
+            }
+        }
+    }
+    for (; i < count; i++) {
+        if (cell.left[i] < q[2] && q[0] < cell.right[i] && cell.top[i] < q[3] && q[1] < cell.bottom[i] && cell.order[i] < bestOrder) {
+            best = (int)i;
+            bestOrder = cell.order[i];
+        }
+    }
+    return best;
+}
+
+static bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    //The OS has to save the AVX registers too.
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static CellKernel activeKernel = scalarKernel;
+static const char* activeKernelName = "scalar";
+
+void SpatialHash::useKernel(KERNEL kernel) {
+    activeKernel = scalarKernel;
+    activeKernelName = "scalar";
+#ifdef SIMD_X86
+    if ((kernel == AUTO || kernel == AVX2) && cpuHasAvx2()) {
+        activeKernel = avx2Kernel;
+        activeKernelName = "avx2";
+    }
+    else if (kernel != SCALAR) {
+        //Every x86 CPU that runs this has SSE2.
+        activeKernel = sseKernel;
+        activeKernelName = "sse";
+    }
+#endif
+}
+
+const char* SpatialHash::kernelName() {
+    return activeKernelName;
+}
+
+/**
+* Pick the best kernel before main() runs.
+*/
+static bool kernelPicked = (SpatialHash::useKernel(SpatialHash::AUTO), true);
+
+SpatialHash::SpatialHash(float cellSize) {
+    this->cellSize = cellSize;
+}
+
+int64_t SpatialHash::cellKey(int x, int y) {
+    return ((int64_t)x << 32) | (uint32_t)y;
+}
+
+void SpatialHash::cellRange(Entry* entry) {
+    //Boxes with no area never intersect anything, so they don't go in any cell.
+    if (!(entry->bounds.width > 0 && entry->bounds.height > 0)) {
+        entry->minX = entry->minY = 0;
+        entry->maxX = entry->maxY = -1;
+        return;
+    }
+    //Inclusive of the far edge. Objects that only touch a cell get checked there too, which is harmless.
+    entry->minX = (int)std::floor(entry->bounds.left / cellSize);
+    entry->minY = (int)std::floor(entry->bounds.top / cellSize);
+    entry->maxX = (int)std::floor((entry->bounds.left + entry->bounds.width) / cellSize);
+    entry->maxY = (int)std::floor((entry->bounds.top + entry->bounds.height) / cellSize);
+}
+
+void SpatialHash::link(GameObject* object, const Entry& entry) {
+    float right = entry.bounds.left + entry.bounds.width;
+    float bottom = entry.bounds.top + entry.bounds.height;
+    for (int x = entry.minX; x <= entry.maxX; x++) {
+        for (int y = entry.minY; y <= entry.maxY; y++) {
+            Cell& cell = cells[cellKey(x, y)];
+            cell.left.push_back(entry.bounds.left);
+            cell.top.push_back(entry.bounds.top);
+            cell.right.push_back(right);
+            cell.bottom.push_back(bottom);
+            cell.order.push_back(entry.order);
+            cell.objects.push_back(object);
+        }
+    }
+}
+
+void SpatialHash::unlink(GameObject* object, const Entry& entry) {
+    for (int x = entry.minX; x <= entry.maxX; x++) {
+        for (int y = entry.minY; y <= entry.maxY; y++) {
+            auto found = cells.find(cellKey(x, y));
+            if (found == cells.end()) {
+                continue;
+            }
+            Cell& cell = found->second;
+            size_t i = std::find(cell.objects.begin(), cell.objects.end(), object) - cell.objects.begin();
+            if (i == cell.objects.size()) {
+                continue;
+            }
+            //Order inside a cell doesn't matter, so swap with the back instead of shifting.
+            size_t last = cell.objects.size() - 1;
+            cell.left[i] = cell.left[last];
+            cell.top[i] = cell.top[last];
+            cell.right[i] = cell.right[last];
+            cell.bottom[i] = cell.bottom[last];
+            cell.order[i] = cell.order[last];
+            cell.objects[i] = cell.objects[last];
+            cell.left.pop_back();
+            cell.top.pop_back();
+            cell.right.pop_back();
+            cell.bottom.pop_back();
+            cell.order.pop_back();
+            cell.objects.pop_back();
+            if (cell.objects.empty()) {
+                cells.erase(found);
+            }
+        }
+    }
+}
+
+void SpatialHash::rewrite(GameObject* object, const Entry& entry) {
+    float right = entry.bounds.left + entry.bounds.width;
+    float bottom = entry.bounds.top + entry.bounds.height;
+    for (int x = entry.minX; x <= entry.maxX; x++) {
+        for (int y = entry.minY; y <= entry.maxY; y++) {
+            auto found = cells.find(cellKey(x, y));
+            if (found == cells.end()) {
+                continue;
+            }
+            Cell& cell = found->second;
+            size_t i = std::find(cell.objects.begin(), cell.objects.end(), object) - cell.objects.begin();
+            if (i == cell.objects.size()) {
+                continue;
+            }
+            cell.left[i] = entry.bounds.left;
+            cell.top[i] = entry.bounds.top;
+            cell.right[i] = right;
+            cell.bottom[i] = bottom;
+        }
+    }
+}
+
+void SpatialHash::insert(GameObject* object, sf::FloatRect bounds) {
+    if (entries.count(object) != 0) {
+        update(object, bounds);
+        return;
+    }
+    Entry entry;
+    entry.bounds = bounds;
+    entry.order = nextOrder++;
+    cellRange(&entry);
+    link(object, entry);
+    entries.insert({ object, entry });
+}
+
+void SpatialHash::update(GameObject* object, sf::FloatRect bounds) {
+    auto found = entries.find(object);
+    if (found == entries.end()) {
+        insert(object, bounds);
+        return;
+    }
+    Entry& entry = found->second;
+    Entry moved = entry;
+    moved.bounds = bounds;
+    cellRange(&moved);
+    if (moved.minX != entry.minX || moved.minY != entry.minY || moved.maxX != entry.maxX || moved.maxY != entry.maxY) {
+        unlink(object, entry);
+        link(object, moved);
+    }
+    else {
+        rewrite(object, moved);
+    }
+    entry = moved;
+}
+
+void SpatialHash::remove(GameObject* object) {
+    auto found = entries.find(object);
+    if (found == entries.end()) {
+        return;
+    }
+    unlink(object, found->second);
+    entries.erase(found);
+}
+
+void SpatialHash::clear() {
+    cells.clear();
+    entries.clear();
+}
+
+bool SpatialHash::query(sf::FloatRect bounds, GameObject** found) {
+    Entry range;
+    range.bounds = bounds;
+    cellRange(&range);
+    float q[4] = { bounds.left, bounds.top, bounds.left + bounds.width, bounds.top + bounds.height };
+
+    GameObject* best = nullptr;
+    uint64_t bestOrder = UINT64_MAX;
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell == cells.end()) {
+                continue;
+            }
+            //An object in several cells is seen more than once. The order check makes that harmless.
+            int i = activeKernel(cell->second, q, bestOrder);
+            if (i >= 0) {
+                best = cell->second.objects[i];
+                bestOrder = cell->second.order[i];
+            }
+        }
+    }
+    if (best == nullptr) {
+        return false;
+    }
+    *found = best;
+    return true;
+}
+
+int SpatialHash::queryAll(sf::FloatRect bounds, Contact* contacts, int capacity) {
+    Entry range;
+    range.bounds = bounds;
+    cellRange(&range);
+    float q[4] = { bounds.left, bounds.top, bounds.left + bounds.width, bounds.top + bounds.height };
+
+    int count = 0;
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell == cells.end()) {
+                continue;
+            }
+            const Cell& c = cell->second;
+            for (size_t i = 0; i < c.objects.size(); i++) {
+                if (!(c.left[i] < q[2] && q[0] < c.right[i] && c.top[i] < q[3] && q[1] < c.bottom[i])) {
+                    continue;
+                }
+                //An object in several cells is only reported from the first of them the query covers.
+                int firstX = std::max((int)std::floor(c.left[i] / cellSize), range.minX);
+                int firstY = std::max((int)std::floor(c.top[i] / cellSize), range.minY);
+                if (x != firstX || y != firstY) {
+                    continue;
+                }
+                if (count == capacity) {
+                    return count;
+                }
+                contacts[count].object = c.objects[i];
+                contacts[count].bounds = sf::FloatRect(c.left[i], c.top[i], c.right[i] - c.left[i], c.bottom[i] - c.top[i]);
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+* Entry and exit times of one axis of a swept box. Returns false if the axis never overlaps.
+*/
+static bool sweepAxis(float minA, float maxA, float minB, float maxB, float motion, float* entry, float* exit) {
+    if (motion == 0.f) {
+        //Standing still on this axis, so it either overlaps the whole time or never.
+        *entry = -INFINITY;
+        *exit = INFINITY;
+        return minA < maxB && minB < maxA;
+    }
+    float first = (motion > 0.f ? minB - maxA : maxB - minA) / motion;
+    float last = (motion > 0.f ? maxB - minA : minB - maxA) / motion;
+    *entry = first;
+    *exit = last;
+    return true;
+}
+
+bool SpatialHash::sweepBox(sf::FloatRect moving, sf::Vector2f motion, sf::FloatRect other, float* time, sf::Vector2f* normal) {
+    float entryX, exitX, entryY, exitY;
+    if (!sweepAxis(moving.left, moving.left + moving.width, other.left, other.left + other.width, motion.x, &entryX, &exitX)) {
+        return false;
+    }
+    if (!sweepAxis(moving.top, moving.top + moving.height, other.top, other.top + other.height, motion.y, &entryY, &exitY)) {
+        return false;
+    }
+    float entry = std::max(entryX, entryY);
+    float exit = std::min(exitX, exitY);
+    //Already overlapping (entry < 0), never meeting, only touching for an instant, or meeting after the motion.
+    if (entry < 0.f || entry >= exit || entry >= 1.f) {
+        return false;
+    }
+    *time = entry;
+    if (entryX > entryY) {
+        *normal = sf::Vector2f(motion.x > 0.f ? -1.f : 1.f, 0.f);
+    }
+    else {
+        *normal = sf::Vector2f(0.f, motion.y > 0.f ? -1.f : 1.f);
+    }
+    return true;
+}
+
+bool SpatialHash::sweep(sf::FloatRect bounds, sf::Vector2f motion, Contact* hit) {
+    //Every cell the box passes through.
+    Entry range;
+    range.bounds.left = std::min(bounds.left, bounds.left + motion.x);
+    range.bounds.top = std::min(bounds.top, bounds.top + motion.y);
+    range.bounds.width = bounds.width + std::abs(motion.x);
+    range.bounds.height = bounds.height + std::abs(motion.y);
+    cellRange(&range);
+
+    bool found = false;
+    uint64_t bestOrder = UINT64_MAX;
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell == cells.end()) {
+                continue;
+            }
+            const Cell& c = cell->second;
+            for (size_t i = 0; i < c.objects.size(); i++) {
+                sf::FloatRect other(c.left[i], c.top[i], c.right[i] - c.left[i], c.bottom[i] - c.top[i]);
+                float time;
+                sf::Vector2f normal;
+                if (!sweepBox(bounds, motion, other, &time, &normal)) {
+                    continue;
+                }
+                if (found && (time > hit->time || (time == hit->time && c.order[i] >= bestOrder))) {
+                    continue;
+                }
+                found = true;
+                bestOrder = c.order[i];
+                hit->object = c.objects[i];
+                hit->bounds = other;
+                hit->time = time;
+                hit->normal = normal;
+            }
+        }
+    }
+    if (found) {
+        hit->depth = (1.f - hit->time) * std::abs(hit->normal.x != 0.f ? motion.x : motion.y);
+    }
+    return found;
+}
+
+size_t SpatialHash::size() {
+    return entries.size();
+}
@@ -0,0 +1,190 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "GameObject.h"
+
+//Default cell size. One snake segment.
+#define HASH_CELL_SIZE 20.f
+
+/**
+* One object overlapping a query box.
+*/
+struct Contact {
+    GameObject* object;
+    /**
+    * The object's bounds.
+    */
+    sf::FloatRect bounds;
+    /**
+    * How far the query box has to move along normal to stop overlapping.
+    */
+    float depth;
+    /**
+    * Unit axis pointing away from the object, the way to push the query box out.
+    */
+    sf::Vector2f normal;
+    /**
+    * For sweeps, the fraction of the motion done when the box first touches the object. 0 for overlap queries.
+    */
+    float time = 0.f;
+};
+
+/**
+* Uniform grid broadphase for collidable objects. Each object is stored with the bounds it was given and listed in
+* every cell those bounds touch, so a query only looks at objects in the cells it covers.
+* Every cell keeps its objects' bounds in structure-of-arrays float buffers, so the overlap test runs straight down
+* contiguous memory with SSE or AVX2 (picked at startup) instead of touching the objects themselves.
+* The hash keeps its own copy of the bounds. Objects that move must be passed to update() or queries will use
+* their old position. Not thread safe, GameWindow locks around it.
+*/
+class SpatialHash {
+public:
+    /**
+    * Overlap kernels. AUTO picks the best one the CPU supports.
+    */
+    enum KERNEL {
+        AUTO,
+        SCALAR,
+        SSE,
+        AVX2
+    };
+
+    /**
+    * The objects in one cell. Element i of every array belongs to the same object.
+    */
+    struct Cell {
+        std::vector<float> left;
+        std::vector<float> top;
+        std::vector<float> right;
+        std::vector<float> bottom;
+        /**
+        * Order the object was inserted in. Queries that find several objects return the earliest, like the
+        * old linear scan did.
+        */
+        std::vector<uint64_t> order;
+        std::vector<GameObject*> objects;
+    };
+
+private:
+    /**
+    * What the hash knows about one object.
+    */
+    struct Entry {
+        sf::FloatRect bounds;
+        /**
+        * Range of cells the bounds touch, inclusive. Empty (min > max) for objects with no area, which can't
+        * intersect anything.
+        */
+        int minX, minY, maxX, maxY;
+        uint64_t order;
+    };
+
+    float cellSize;
+
+    /**
+    * Cells keyed by cellKey().
+    */
+    std::unordered_map<int64_t, Cell> cells;
+
+    std::unordered_map<GameObject*, Entry> entries;
+
+    uint64_t nextOrder = 0;
+
+    /**
+    * Pack a cell coordinate into one key.
+    */
+    static int64_t cellKey(int x, int y);
+
+    /**
+    * Fill in the cell range of an entry from its bounds.
+    */
+    void cellRange(Entry* entry);
+
+    /**
+    * Add or remove the object from every cell in the entry's range.
+    */
+    void link(GameObject* object, const Entry& entry);
+    void unlink(GameObject* object, const Entry& entry);
+
+    /**
+    * Overwrite the bounds stored for the object in every cell in the entry's range.
+    */
+    void rewrite(GameObject* object, const Entry& entry);
+
+public:
+    SpatialHash(float cellSize = HASH_CELL_SIZE);
+
+    /**
+    * Add an object with the given bounds. Inserting an object that is already in the hash updates it instead.
+    */
+    void insert(GameObject* object, sf::FloatRect bounds);
+
+    /**
+    * Give an object new bounds. Cells are only relinked if the object moved into different cells.
+    */
+    void update(GameObject* object, sf::FloatRect bounds);
+
+    /**
+    * Take an object out of the hash.
+    */
+    void remove(GameObject* object);
+
+    /**
+    * Remove every object.
+    */
+    void clear();
+
+    /**
+    * Find the earliest inserted object whose bounds intersect the given bounds. Intersection is strict, like
+    * sf::FloatRect::intersects: boxes that only share an edge don't intersect.
+    * @param found set to the object if there is one.
+    * @return true if something was found.
+    */
+    bool query(sf::FloatRect bounds, GameObject** found);
+
+    /**
+    * Find every object whose bounds intersect the given bounds, each once, in no particular order.
+    * Fills in object and bounds of up to capacity contacts.
+    * @return the number written.
+    */
+    int queryAll(sf::FloatRect bounds, Contact* contacts, int capacity);
+
+    /**
+    * Move the bounds by motion and find the first object they run into (swept AABB). Objects the bounds already
+    * overlap at the start are ignored, so a mover can't get stuck on what it is leaving. Ties go to the earliest
+    * inserted object.
+    * @param hit set to the object, its bounds, the contact time and the normal of the face that was hit. depth
+    * is the distance along the normal the rest of the motion would have gone into the object.
+    * @return true if something was hit before the end of the motion.
+    */
+    bool sweep(sf::FloatRect bounds, sf::Vector2f motion, Contact* hit);
+
+    /**
+    * The swept AABB test sweep() does for each candidate.
+    * @param time set to the fraction of motion at which moving first touches other.
+    * @param normal set to the normal of the face of other that was touched.
+    * @return false if they don't meet during the motion, or already overlap at the start.
+    */
+    static bool sweepBox(sf::FloatRect moving, sf::Vector2f motion, sf::FloatRect other, float* time, sf::Vector2f* normal);
+
+    /**
+    * Return the number of objects in the hash.
+    */
+    size_t size();
+
+    /**
+    * Choose the overlap kernel for every hash. A kernel the CPU can't run falls back to the next best one.
+    */
+    static void useKernel(KERNEL kernel);
+
+    /**
+    * Return the name of the kernel in use.
+    */
+    static const char* kernelName();
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "Transport.h"
+
+//Inproc does not use I/O threads, so one is plenty. TCP keeps the two every thread used to create for itself.
+Transport::Transport(MODE mode) : context(mode == INPROC ? 1 : 2) {
+    this->mode = mode;
+}
+
+Transport::MODE Transport::getMode() {
+    return mode;
+}
+
+zmq::context_t* Transport::getContext() {
+    return &context;
+}
+
+std::string Transport::endpoint(int port) {
+    if (mode == INPROC) {
+        return "inproc://snake-" + std::to_string(port);
+    }
+    return "tcp://localhost:" + std::to_string(port);
+}
+
+MessagePool* Transport::getPool() {
+    return &pool;
+}
+
+Transport::MODE Transport::parseMode(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-inproc") == 0) {
+            return INPROC;
+        }
+    }
+    return TCP;
+}
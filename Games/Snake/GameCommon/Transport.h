@@ -0,0 +1,81 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <zmq.hpp>
+#include <string>
+#include <cstring>
+#include "MessagePool.h"
+
+//Port the server publishes game state on.
+#define PUB_PORT 5555
+//Port the server publishes the arena (every snake and apple) on, once a tic.
+#define BOARD_PORT 5554
+//Port the server publishes leaderboard changes on.
+#define LEADERBOARD_PORT 5553
+//Port new clients connect to for their ID and personal port.
+#define HANDSHAKE_PORT 5556
+//First personal port handed out to a client. Every new client gets the next one.
+#define FIRST_CLIENT_PORT 5557
+
+/**
+* Transport decides how the server and its clients reach each other.
+* In TCP mode every endpoint is tcp://localhost:<port>, which is what a normal client/server setup uses.
+* In INPROC mode every endpoint is inproc://snake-<port>. Inproc sockets only work inside one zmq context,
+* so one Transport should be shared by the server and every client that runs in the same process.
+* Inproc messages are handed between threads by pointer, so there is no copy and no network stack in the way.
+*/
+class Transport {
+public:
+    enum MODE {
+        TCP,
+        INPROC
+    };
+
+    /**
+    * Create a transport using the given mode. The context is created here and shared by every socket made from it.
+    */
+    Transport(MODE mode);
+
+    /**
+    * Return the mode of this transport.
+    */
+    MODE getMode();
+
+    /**
+    * Return the shared context. Every socket that uses this transport must be created from this context.
+    */
+    zmq::context_t* getContext();
+
+    /**
+    * Return the endpoint string for the given port, e.g. "tcp://localhost:5555" or "inproc://snake-5555".
+    */
+    std::string endpoint(int port);
+
+    /**
+    * Return the pool every outgoing message should be built from.
+    */
+    MessagePool* getPool();
+
+    /**
+    * Read the transport mode from the command line. "-inproc" selects INPROC, anything else is TCP.
+    */
+    static MODE parseMode(int argc, char** argv);
+
+private:
+    /**
+    * The mode of this transport.
+    */
+    MODE mode;
+
+    /**
+    * Buffers for outgoing messages. Declared before the context so it outlives every message zmq still holds.
+    */
+    MessagePool pool;
+
+    /**
+    * The context shared by every socket that uses this transport.
+    */
+    zmq::context_t context;
+};
+
+#endif
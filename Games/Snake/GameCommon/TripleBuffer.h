@@ -0,0 +1,73 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+* Hands the latest value from one writer thread to one reader thread without either of them ever waiting.
+* The writer fills writeBuffer() and calls publish(). The reader calls consume() and, if it returns true, reads
+* readBuffer() until its next consume(). Each side owns one of the three buffers and the third sits in the middle
+* holding the newest published value, so a slow reader just skips values instead of holding the writer up.
+* The buffer the writer gets back is one it wrote before, so it must overwrite everything in it.
+*/
+template <class T>
+class TripleBuffer {
+private:
+    /**
+    * Set in middle when it holds a value the reader hasn't taken yet.
+    */
+    static const int FRESH = 4;
+
+    T buffers[3];
+
+    /**
+    * Index of the writer's buffer. Only the writer touches it.
+    */
+    int back = 0;
+
+    /**
+    * Index of the buffer in the middle, plus FRESH.
+    */
+    std::atomic<int> middle{ 1 };
+
+    /**
+    * Index of the reader's buffer. Only the reader touches it.
+    */
+    int front = 2;
+
+public:
+    /**
+    * The buffer to fill before the next publish().
+    */
+    T* writeBuffer() {
+        return &buffers[back];
+    }
+
+    /**
+    * Make the write buffer the newest value and take the middle one to write into next.
+    */
+    void publish() {
+        back = middle.exchange(back | FRESH) & 3;
+    }
+
+    /**
+    * Take the newest value if there is one the reader hasn't seen.
+    * @return false if nothing was published since the last consume().
+    */
+    bool consume() {
+        if (!(middle.load() & FRESH)) {
+            return false;
+        }
+        front = middle.exchange(front) & 3;
+        return true;
+    }
+
+    /**
+    * The value taken by the last consume().
+    */
+    T* readBuffer() {
+        return &buffers[front];
+    }
+};
+
+#endif
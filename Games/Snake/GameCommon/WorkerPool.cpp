@@ -0,0 +1,77 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int threads) {
+    next = 0;
+    finished = 0;
+    for (int i = 0; i < threads; i++) {
+        this->threads.emplace_back(&WorkerPool::runThread, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    workReady.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::work(Task task, void* context, int count) {
+    while (true) {
+        int i = next++;
+        if (i >= count) {
+            break;
+        }
+        task(context, i);
+        finished++;
+    }
+}
+
+void WorkerPool::runThread() {
+    std::unique_lock<std::mutex> lock(mutex);
+    int64_t seen = 0;
+    while (true) {
+        workReady.wait(lock, [&]() { return stopped || generation != seen; });
+        if (stopped) {
+            return;
+        }
+        seen = generation;
+        busy++;
+        Task task = this->task;
+        void* context = this->context;
+        int count = this->count;
+        lock.unlock();
+        work(task, context, count);
+        lock.lock();
+        busy--;
+        workDone.notify_all();
+    }
+}
+
+void WorkerPool::run(int count, Task task, void* context) {
+    //Not worth waking anyone for.
+    if (threads.empty() || count <= 1) {
+        for (int i = 0; i < count; i++) {
+            task(context, i);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = task;
+        this->context = context;
+        this->count = count;
+        next = 0;
+        finished = 0;
+        generation++;
+    }
+    workReady.notify_all();
+    work(task, context, count);
+
+    //Everything is taken. Wait for pool threads still running what they took.
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [&]() { return finished == count && busy == 0; });
+}
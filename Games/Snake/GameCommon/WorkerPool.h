@@ -0,0 +1,85 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* A fixed set of threads for running a parallel for. run() calls a task once for every index, and the pool's
+* threads and the calling thread take indices one at a time until none are left, so a slow index doesn't hold up
+* the ones after it. A server has one, which steps its rooms, and the regions of its arena when it has one room.
+* Only one thread may call run(), and the task may only call it again if the outer run() had a single index: that
+* one is run on the calling thread without touching the pool.
+*/
+class WorkerPool {
+public:
+    /**
+    * What run() calls for each index, with the context it was given.
+    */
+    typedef void (*Task)(void* context, int i);
+
+private:
+    /**
+    * The task being run, for how many indices. Set by run() under mutex, and copied under it by every pool thread
+    * that takes part, so a thread that wakes late never mixes them up with the next run()'s.
+    */
+    Task task = nullptr;
+    void* context = nullptr;
+    int count = 0;
+
+    /**
+    * Bumped by every run(), so the threads know there is work. Protected by mutex, like busy and stopped.
+    */
+    int64_t generation = 0;
+    /**
+    * Pool threads working on the current run().
+    */
+    int busy = 0;
+    bool stopped = false;
+
+    /**
+    * Next index nobody has taken, and the number of indices done.
+    */
+    std::atomic<int> next;
+    std::atomic<int> finished;
+
+    std::mutex mutex;
+    /**
+    * Signalled when there is work or the pool stops, and when a pool thread is done with a run().
+    */
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+
+    std::vector<std::thread> threads;
+
+    /**
+    * Run a task for indices nobody has taken until there are none left.
+    */
+    void work(Task task, void* context, int count);
+
+    /**
+    * Body of a pool thread.
+    */
+    void runThread();
+
+public:
+    /**
+    * Start a pool with the given number of threads. With 0, run() does everything itself.
+    */
+    WorkerPool(int threads);
+
+    /**
+    * Stop and join the threads.
+    */
+    ~WorkerPool();
+
+    /**
+    * Call task(context, i) for every i in [0, count), using the pool's threads and the calling thread, and return
+    * when all are done. A single index is run on the calling thread without waking anyone.
+    */
+    void run(int count, Task task, void* context);
+};
+#endif
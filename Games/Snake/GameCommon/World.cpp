@@ -0,0 +1,279 @@
+#include "World.h"
+#include <algorithm>
+
+RegisteredObject::RegisteredObject(GameObject* object) {
+    this->object = object;
+    drawable = dynamic_cast<sf::Drawable*>(object);
+    shape = dynamic_cast<sf::Shape*>(object);
+    rectangle = dynamic_cast<sf::RectangleShape*>(object);
+    type = object->getObjectType();
+}
+
+World::World() {
+}
+
+void World::setObserver(WorldObserver* observer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->observer = observer;
+}
+
+std::mutex* World::getMutex() {
+    return &mutex;
+}
+
+std::vector<RegisteredObject>* World::getNonStaticRegistered() {
+    return &nonStaticRegistered;
+}
+
+RegisteredObject* World::getPlayer() {
+    return &player;
+}
+
+void World::clearStaticObjects()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    staticObjects.clear();
+    movingObjects.clear();
+    handles.clear();
+    collidables.clear();
+    if (observer != nullptr) {
+        observer->objectsCleared();
+    }
+}
+
+bool World::checkCollisions(GameObject** collides) {
+    bool foundCollision = false;
+    //Cycle through the list of collidables and check if they collide with the player.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sf::FloatRect bounds = player.shape->getGlobalBounds();
+        if (collidables.query(bounds, collides)) {
+            // Return static collisions first.
+            return true;
+        }
+        //Server objects are replaced every frame, so they aren't worth hashing.
+        for (RegisteredObject& i : nonStaticRegistered) {
+            if (i.shape != nullptr && i.object->isCollidable() && bounds.intersects(i.shape->getGlobalBounds())) {
+                // If the found collision is not moving, return it immediately
+                *collides = i.object;
+                return true;
+
+            }
+        }
+
+    }
+    // No collision found.
+    return false;
+}
+
+/**
+* Fill in the depth and normal of a contact, using the axis with the least overlap.
+*/
+static void resolveContact(sf::FloatRect bounds, Contact* contact) {
+    sf::FloatRect& other = contact->bounds;
+    float pushLeft = bounds.left + bounds.width - other.left;
+    float pushRight = other.left + other.width - bounds.left;
+    float pushUp = bounds.top + bounds.height - other.top;
+    float pushDown = other.top + other.height - bounds.top;
+    float x = std::min(pushLeft, pushRight);
+    float y = std::min(pushUp, pushDown);
+    if (x < y) {
+        contact->depth = x;
+        contact->normal = sf::Vector2f(pushLeft < pushRight ? -1.f : 1.f, 0.f);
+    }
+    else {
+        contact->depth = y;
+        contact->normal = sf::Vector2f(0.f, pushUp < pushDown ? -1.f : 1.f);
+    }
+}
+
+int World::findContacts(sf::FloatRect bounds, Contact* contacts, int capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int count = collidables.queryAll(bounds, contacts, capacity);
+    for (RegisteredObject& i : nonStaticRegistered) {
+        if (count == capacity) {
+            break;
+        }
+        if (i.shape != nullptr && i.object->isCollidable()) {
+            sf::FloatRect other = i.shape->getGlobalBounds();
+            if (bounds.intersects(other)) {
+                contacts[count].object = i.object;
+                contacts[count].bounds = other;
+                count++;
+            }
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        resolveContact(bounds, &contacts[i]);
+    }
+    return count;
+}
+
+int World::checkContacts(Contact* contacts, int capacity) {
+    sf::FloatRect bounds;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bounds = player.shape->getGlobalBounds();
+    }
+    return findContacts(bounds, contacts, capacity);
+}
+
+bool World::sweepContact(sf::FloatRect bounds, sf::Vector2f motion, Contact* hit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool found = collidables.sweep(bounds, motion, hit);
+    //Static hits win ties, like checkCollisions.
+    for (RegisteredObject& i : nonStaticRegistered) {
+        if (i.shape == nullptr || !i.object->isCollidable()) {
+            continue;
+        }
+        float time;
+        sf::Vector2f normal;
+        sf::FloatRect other = i.shape->getGlobalBounds();
+        if (SpatialHash::sweepBox(bounds, motion, other, &time, &normal) && (!found || time < hit->time)) {
+            found = true;
+            hit->object = i.object;
+            hit->bounds = other;
+            hit->time = time;
+            hit->normal = normal;
+            hit->depth = (1.f - time) * std::abs(normal.x != 0.f ? motion.x : motion.y);
+        }
+    }
+    return found;
+}
+
+//Add this client's playable character.
+void World::addPlayableObject(GameObject* character) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->character = character;
+    player = RegisteredObject(character);
+}
+
+GameObject* World::getPlayableObject() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return character;
+}
+
+ObjectHandle World::addGameObject(GameObject *object) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = handles.find(object);
+    if (found != handles.end()) {
+        refresh(found->second);
+        return found->second;
+    }
+    //The only casts an object ever gets.
+    RegisteredObject entry(object);
+    ObjectHandle handle;
+    handle.isStatic = object->isStatic();
+    handle.slot = (handle.isStatic ? staticObjects : movingObjects).insert(entry);
+    handles.insert({ object, handle });
+    if (object->isCollidable()) {
+        collidables.insert(object, entry.shape->getGlobalBounds());
+    }
+    if (observer != nullptr) {
+        observer->objectAdded(entry);
+    }
+    return handle;
+}
+
+RegisteredObject* World::find(ObjectHandle handle) {
+    return (handle.isStatic ? staticObjects : movingObjects).get(handle.slot);
+}
+
+void World::refresh(ObjectHandle handle) {
+    RegisteredObject* entry = find(handle);
+    if (entry == nullptr) {
+        return;
+    }
+    if (entry->object->isCollidable()) {
+        collidables.update(entry->object, entry->shape->getGlobalBounds());
+    }
+    if (observer != nullptr) {
+        observer->objectChanged(*entry);
+    }
+}
+
+void World::refreshGameObject(ObjectHandle handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    refresh(handle);
+}
+
+void World::refreshGameObject(GameObject* object) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = handles.find(object);
+    if (found != handles.end()) {
+        refresh(found->second);
+    }
+}
+
+void World::remove(ObjectHandle handle) {
+    RegisteredObject* entry = find(handle);
+    if (entry == nullptr) {
+        return;
+    }
+    RegisteredObject removed = *entry;
+    (handle.isStatic ? staticObjects : movingObjects).remove(handle.slot);
+    handles.erase(removed.object);
+    collidables.remove(removed.object);
+    if (observer != nullptr) {
+        observer->objectRemoved(removed);
+    }
+}
+
+void World::removeGameObject(ObjectHandle handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    remove(handle);
+}
+
+void World::removeGameObject(GameObject* object) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = handles.find(object);
+    if (found != handles.end()) {
+        remove(found->second);
+    }
+}
+
+//Contains client objects like death bounds and side bounds.
+SlotMap<RegisteredObject>* World::getStaticObjects() {
+    return &staticObjects;
+}
+//Contains server objects like moving platforms and other characters.
+std::vector<std::shared_ptr<GameObject>>* World::getNonstaticObjects() {
+    return &nonStaticObjects;
+}
+
+void World::addTemplate(std::shared_ptr<GameObject> templateObject) {
+    std::lock_guard<std::mutex> lock(mutex);
+    templates.insert_or_assign(templateObject->getObjectType(), templateObject);
+}
+
+void World::updateNonStatic(std::string updates) {
+    std::lock_guard<std::mutex> lock(mutex);
+    //Every update has all of the server's objects, so the last ones are replaced.
+    nonStaticObjects.clear();
+    nonStaticRegistered.clear();
+
+    char* currentObject = (char*)malloc(updates.size() + 1);
+    if (currentObject == NULL) {
+        throw std::runtime_error("Memory error while updating static objects");
+    }
+    int pos = 0;
+    int newPos = 0;
+
+    //Scan through each object
+    while (sscanf_s(updates.data() + pos, "%[^,]%n", currentObject,(unsigned int)(updates.size() + 1), &newPos) == 1) {
+        //Get the type of the current object.
+        int type;
+        int matches = sscanf_s(currentObject, "%d", &type);
+        if (matches != 1) {
+            free(currentObject);
+            throw std::invalid_argument("Failed to read string. Type must be the first value.");
+        }
+        //Push the newly created object into the array.
+        nonStaticObjects.push_back((templates.at(type))->constructSelf(currentObject));
+        nonStaticRegistered.push_back(RegisteredObject(nonStaticObjects.back().get()));
+        //update position and skip past comma
+        pos += newPos + 1;
+
+    }
+    free(currentObject);
+}
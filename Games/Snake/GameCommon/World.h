@@ -0,0 +1,250 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Character.h"
+#include "Platform.h"
+#include "SpatialHash.h"
+#include "SlotMap.h"
+
+//Contacts a handler can take from one findContacts call.
+#define MAX_CONTACTS 16
+
+/**
+* An object added to the world, with the SFML interfaces it implements looked up once when it is added.
+* The draw and collision loops use these instead of casting every frame.
+*/
+struct RegisteredObject {
+    GameObject* object = nullptr;
+    /**
+    * nullptr if the object isn't drawable.
+    */
+    const sf::Drawable* drawable = nullptr;
+    /**
+    * nullptr if the object isn't an sf::Shape.
+    */
+    sf::Shape* shape = nullptr;
+    /**
+    * nullptr if the object isn't an sf::RectangleShape.
+    */
+    sf::RectangleShape* rectangle = nullptr;
+    /**
+    * The object's getObjectType().
+    */
+    int type = 0;
+
+    RegisteredObject() {}
+    RegisteredObject(GameObject* object);
+};
+
+/**
+* Refers to an object added to a World. Goes stale when the object is removed or the world is cleared.
+*/
+struct ObjectHandle {
+    SlotHandle slot;
+    /**
+    * Which of the world's slot maps the object is in.
+    */
+    bool isStatic = false;
+};
+
+/**
+* Told about every change to a World's objects, so a view can keep its own copies up to date.
+* Called with the world's mutex held, so it must not call back into the world.
+*/
+class WorldObserver {
+public:
+    virtual ~WorldObserver() {}
+
+    virtual void objectAdded(const RegisteredObject& object) = 0;
+
+    /**
+    * The object moved or changed color (refreshGameObject).
+    */
+    virtual void objectChanged(const RegisteredObject& object) = 0;
+
+    /**
+    * The object was taken out of the world (removeGameObject).
+    */
+    virtual void objectRemoved(const RegisteredObject& object) = 0;
+
+    /**
+    * clearStaticObjects was called.
+    */
+    virtual void objectsCleared() = 0;
+};
+
+/**
+* The objects in a game and the collisions between them, without any windowing. The server, bots and benchmarks
+* can use it headless. GameWindow draws one.
+* You can add collidables, assign a character, and add non-static objects sent by the server.
+* Then the contact and collision methods check the character (or any box) against all of them.
+* Every method locks the world's mutex, so the world can be shared between threads.
+*/
+class World {
+
+private:
+
+    /**
+    * Every object added with addGameObject, packed by category so walking one is a straight run through memory.
+    * Static objects (walls, platforms) and everything else.
+    */
+    SlotMap<RegisteredObject> staticObjects;
+    SlotMap<RegisteredObject> movingObjects;
+    /**
+    * The handle of every added object, so the GameObject* methods can find it.
+    */
+    std::unordered_map<GameObject*, ObjectHandle> handles;
+    /**
+    * Every collidable added to the world, bucketed by position so checkCollisions only looks nearby.
+    */
+    SpatialHash collidables;
+    /**
+    * The objects from the last updateNonStatic. Only here to own them; loops use nonStaticRegistered.
+    */
+    std::vector<std::shared_ptr<GameObject>> nonStaticObjects;
+    /**
+    * The drawable or collidable non-static objects from the last updateNonStatic.
+    */
+    std::vector<RegisteredObject> nonStaticRegistered;
+    /**
+    * Templates used in the drawing/collisions of non-static objects.
+    */
+    std::map<int, std::shared_ptr<GameObject>> templates;
+
+    /**
+    * The single, playable character object in the world.
+    */
+    GameObject* character = nullptr;
+    /**
+    * The character's interfaces, looked up in addPlayableObject.
+    */
+    RegisteredObject player;
+
+    /**
+    * Told about added, changed and cleared objects. May be nullptr.
+    */
+    WorldObserver* observer = nullptr;
+
+    std::mutex mutex;
+
+    /**
+    * Look up, refresh or remove by handle. The caller holds mutex.
+    */
+    RegisteredObject* find(ObjectHandle handle);
+    void refresh(ObjectHandle handle);
+    void remove(ObjectHandle handle);
+
+public:
+    World();
+
+    /**
+    * Set the observer told about object changes. Set it before adding objects; ones already added aren't replayed.
+    */
+    void setObserver(WorldObserver* observer);
+
+    /**
+    * Remove every static object and collidable.
+    */
+    void clearStaticObjects();
+
+    /**
+    Check collisions of all collidables versus the character.
+    @param collides Returns the CBox that the character collided with (stationary platforms take precedence)
+    I.E if a player is colliding with both a moving platform and a stationary platform, the stationary platform will be returned here.
+    @return boolean value for if a collision was found.
+    */
+    bool checkCollisions(GameObject** collides);
+
+    /**
+    * Find everything the bounds overlap in one sweep: static collidables first, then non-static ones.
+    * Each contact gets its penetration depth and the normal to push the bounds out along.
+    * @param contacts caller's buffer, filled with up to capacity contacts.
+    * @return the number of contacts written.
+    */
+    int findContacts(sf::FloatRect bounds, Contact* contacts, int capacity);
+
+    /**
+    * findContacts for the character.
+    */
+    int checkContacts(Contact* contacts, int capacity);
+
+    /**
+    * Find the first thing the bounds run into when moved by motion, static or non-static. Non-static objects are
+    * treated as standing still, so movers should pass their motion relative to them.
+    * @param hit set to the earliest contact, with time as the fraction of motion done when it happens.
+    * @return true if something was hit before the end of the motion.
+    */
+    bool sweepContact(sf::FloatRect bounds, sf::Vector2f motion, Contact* hit);
+
+    /**
+    * Add an object to the world. By default it is added to the list of platforms and collidables.
+    * Adding an object that is already in the world refreshes it instead.
+    * @return the handle to refresh or remove it with.
+    */
+    ObjectHandle addGameObject(GameObject* object);
+
+    /**
+    * Tell the world an object has moved or changed color. Anything that changes an object after adding it must call this.
+    */
+    void refreshGameObject(ObjectHandle handle);
+    void refreshGameObject(GameObject* object);
+
+    /**
+    * Take an object out of the world. Stale handles and objects that were never added are ignored.
+    */
+    void removeGameObject(ObjectHandle handle);
+    void removeGameObject(GameObject* object);
+
+    /**
+    * Add the playable character to the world. Only one character is supported.
+    */
+    void addPlayableObject(GameObject* character);
+
+    /**
+    * Return the static objects. Only valid while holding getMutex().
+    */
+    SlotMap<RegisteredObject>* getStaticObjects();
+
+    /**
+    * Return the objects from the last updateNonStatic. Only valid while holding getMutex().
+    */
+    std::vector<std::shared_ptr<GameObject>>* getNonstaticObjects();
+
+    /**
+    * return a pointer to the character.
+    */
+    GameObject* getPlayableObject();
+
+    /**
+    * Replace the non-static objects using a string that contains information about all of them.
+    */
+    void updateNonStatic(std::string updates);
+
+    /**
+    * Add an empty template object to the world.
+    */
+    void addTemplate(std::shared_ptr<GameObject> templateObject);
+
+    /**
+    * The mutex every method locks. Hold it while using getNonStaticRegistered() or getPlayer().
+    */
+    std::mutex* getMutex();
+
+    /**
+    * The non-static objects with their interfaces. Only valid while holding getMutex().
+    */
+    std::vector<RegisteredObject>* getNonStaticRegistered();
+
+    /**
+    * The character with its interfaces. Only valid while holding getMutex().
+    */
+    RegisteredObject* getPlayer();
+};
+
+#endif
@@ -1,7 +1,24 @@
 #include "v8helpers.h"
+#include <cstdlib>
 
 namespace v8helpers
 {
+	/** Guards v8Users and v8Initialized. */
+	static std::mutex v8Mutex;
+
+	/** Number of threads currently using the v8 platform. */
+	static int v8Users = 0;
+
+	/** Set once the platform is up. v8 can't be initialized again after it is disposed, so it stays up until exit. */
+	static bool v8Initialized = false;
+
+	/**
+	 * Dispose of v8 when the process exits, after every thread using it has been joined.
+	 */
+	static void DisposeV8() {
+		v8::V8::Dispose();
+		v8::V8::ShutdownPlatform();
+	}
 
 	/**
 	 * Extracts a C string from a V8 Utf8Value.
@@ -11,6 +28,24 @@ namespace v8helpers
 		return *value ? *value : "<string conversion failed>";
 	}
 
+	void InitializeV8() {
+		std::lock_guard<std::mutex> lock(v8Mutex);
+		v8Users++;
+		if (!v8Initialized) {
+			std::unique_ptr<v8::Platform> platform = v8::platform::NewDefaultPlatform();
+			v8::V8::InitializePlatform(platform.release());
+			v8::V8::InitializeICU();
+			v8::V8::Initialize();
+			v8Initialized = true;
+			atexit(DisposeV8);
+		}
+	}
+
+	void ShutdownV8() {
+		std::lock_guard<std::mutex> lock(v8Mutex);
+		v8Users--;
+	}
+
 	/**
 	 * The callback that is invoked by v8 whenever the JavaScript 'print'
 	 * function is called.  Prints its arguments on stdout separated by spaces
@@ -2,7 +2,9 @@
 #define V8HELPERS_H
 
 #include <v8.h>
+#include <libplatform/libplatform.h>
 #include <iostream>
+#include <mutex>
 
 #define V8H_DEBUG 0
 
@@ -23,6 +25,20 @@ namespace v8helpers
 	 */
 	const char* ToCString(const v8::String::Utf8Value& value);
 
+	/**
+	 * Initialize the v8 platform. v8 may only be initialized once per process, so threads that
+	 * make their own isolate call this instead of initializing v8 themselves. The first call brings
+	 * the platform up and it stays up until the process exits. Every call must be matched by a call
+	 * to ShutdownV8.
+	 */
+	void InitializeV8();
+
+	/**
+	 * Release one use of the v8 platform. The platform is not disposed here, since a server or client
+	 * started again in the same process would need it back; it is disposed at exit.
+	 */
+	void ShutdownV8();
+
 	/**
 	 * NOTE: This struct is expected to be used when calling the
 	 * v8helpers::exposeToV8(...) function.
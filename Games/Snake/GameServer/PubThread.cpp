@@ -1,76 +1,63 @@
 #include "PubThread.h"
+#include <algorithm>
+#include <chrono>
 
 
-PubThread::PubThread(Timeline *timeline, int *highScore, std::mutex* m, EventManager *manager) {
+PubThread::PubThread(Transport* transport, Timeline *timeline, std::vector<Room*>* rooms, RoomPool* roomPool, EventManager *manager, std::atomic<bool>* stopped) {
+    this->rooms = rooms;
+    this->roomPool = roomPool;
+    this->transport = transport;
+    this->stopped = stopped;
     this->timeline = timeline;
-    this->highScore = highScore;
-    this->mutex = m;
     this->manager = manager;
 }
 
-void PubThread::run() {
-
-    std::unique_ptr<v8::Platform> platform = v8::platform::NewDefaultPlatform();
-    v8::V8::InitializePlatform(platform.release());
-    v8::V8::InitializeICU();
-    v8::V8::Initialize();
-    v8::Isolate::CreateParams create_params;
-    create_params.array_buffer_allocator = v8::ArrayBuffer::Allocator::NewDefaultAllocator();
-    v8::Isolate* isolate = v8::Isolate::New(create_params);
-
-    { // anonymous scope for managing handle scope
-        v8::Isolate::Scope isolate_scope(isolate); // must enter the virtual machine to do stuff
-        v8::HandleScope handle_scope(isolate);
-
-        //Best practice to isntall all global functions in the context ahead of time.
-        v8::Local<v8::ObjectTemplate> global = v8::ObjectTemplate::New(isolate);
-        // Bind the global 'print' function to the C++ Print callback.
-        global->Set(isolate, "print", v8::FunctionTemplate::New(isolate, v8helpers::Print));
-        // Bind the global static factory function for creating new GameObject instances
-        global->Set(isolate, "makeEvent", v8::FunctionTemplate::New(isolate, Event::ScriptedGameObjectFactory));
-        // Bind the global static function for retrieving object handles
-        global->Set(isolate, "gethandle", v8::FunctionTemplate::New(isolate, ScriptManager::getHandleFromScript));
-
-        global->Set(isolate, "raise", v8::FunctionTemplate::New(isolate, EventManager::raiseEventFromScript));
-
-        global->Set(isolate, "moreArgs", v8::FunctionTemplate::New(isolate, ScriptManager::getNextArg));
-
-        v8::Local<v8::Context> default_context = v8::Context::New(isolate, NULL, global);
-        v8::Context::Scope default_context_scope(default_context); // enter the context
-        //For raising events, pass an array that is stored in the manager, and can be accessed from the script. Pop the elements off to get the arguments.
-        ScriptManager* sm = new ScriptManager(isolate, default_context);
-
-        sm->addScript("move_platform", "scripts/move_platform.js");
-
-        zmq::context_t context(2);
-        zmq::socket_t pubSocket(context, zmq::socket_type::pub);
-        pubSocket.bind("tcp://localhost:5555");
-
-        int64_t tic = 0;
-        int64_t currentTic = 0;
-        float ticLength;
-        int moves = 0;
-        while (true) {
-            ticLength = timeline->getRealTicLength();
-            currentTic = timeline->getTime();
+void PubThread::buildUpdate(MessagePool* pool, zmq::message_t* message, int room, int highScore, int64_t ticMicros) {
+    pool->format(message, "%d %d %lld", room, highScore, (long long)ticMicros);
+}
 
-            if (currentTic > tic) {
-                //Construct return string
-                std::string rtnString;
-                std::stringstream stream;
-                {
-                    //Add high score to stream
-                    std::lock_guard<std::mutex> lock(*mutex);
-                    stream << *highScore;
-                }
+void PubThread::publish(Room* room, int64_t ticMicros, zmq::socket_t* pubSocket, zmq::socket_t* boardSocket, zmq::socket_t* leaderboardSocket) {
+    room->takeBoard(&boardMessage);
+    boardSocket->send(boardMessage, zmq::send_flags::none);
+    //Send the update to the players. Clients pace themselves on it, so it goes out every tic.
+    buildUpdate(transport->getPool(), &rtnMessage, room->getID(), room->getLeaderboard()->getBest(), ticMicros);
+    pubSocket->send(rtnMessage, zmq::send_flags::none);
+    const std::string* leaders = room->getLeaders();
+    if (leaders != nullptr) {
+        transport->getPool()->copy(&leaderboardMessage, *leaders);
+        leaderboardSocket->send(leaderboardMessage, zmq::send_flags::none);
+    }
+}
 
-                std::getline(stream, rtnString);
-                //Send the string to the players
-                zmq::message_t rtnMessage(rtnString.size() + 1);
-                memcpy(rtnMessage.data(), rtnString.data(), rtnString.size() + 1);
-                pubSocket.send(rtnMessage, zmq::send_flags::none);
-                tic = currentTic;
+void PubThread::run() {
+    zmq::socket_t pubSocket(*transport->getContext(), zmq::socket_type::pub);
+    pubSocket.bind(transport->endpoint(PUB_PORT));
+    //Not conflated on the client side, so it gets its own socket instead of a second frame.
+    zmq::socket_t boardSocket(*transport->getContext(), zmq::socket_type::pub);
+    boardSocket.bind(transport->endpoint(BOARD_PORT));
+    //Deltas only make sense in order, so this one isn't conflated either.
+    zmq::socket_t leaderboardSocket(*transport->getContext(), zmq::socket_type::pub);
+    leaderboardSocket.bind(transport->endpoint(LEADERBOARD_PORT));
+
+    int64_t tic = 0;
+    int64_t currentTic = 0;
+    //How long stepping and publishing every room took last tic, sent along with the high score so load tests can
+    //see the server falling behind. A tic can't include its own sends, so each one carries the one before it.
+    int64_t ticMicros = 0;
+    while (!(*stopped)) {
+        currentTic = timeline->getTime();
+
+        if (currentTic > tic) {
+            std::chrono::steady_clock::time_point ticStart = std::chrono::steady_clock::now();
+
+            //Every snake in every room moves, then everyone hears where they went. Sockets can only be used
+            //from this thread, so the rooms write their messages and they are all sent from here.
+            roomPool->step(rooms, currentTic % BOARD_FULL_TICS == 0, currentTic % LEADERBOARD_FULL_TICS == 0);
+            for (Room* room : *rooms) {
+                publish(room, ticMicros, &pubSocket, &boardSocket, &leaderboardSocket);
             }
+            ticMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ticStart).count();
+            tic = currentTic;
         }
     }
-}
\ No newline at end of file
+}
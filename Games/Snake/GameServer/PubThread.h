@@ -2,12 +2,14 @@
 #define PUBTHREAD_H
 #include <zmq.hpp>
 #include <list>
+#include <atomic>
 #include <iostream> //Remove later. Testing purposes only
 #include "Timeline.h"
 #include "MovingPlatform.h"
 #include "EventManager.h"
-#include "ScriptManager.h"
-#include <libplatform/libplatform.h>
+#include "Transport.h"
+#include "Room.h"
+#include "RoomPool.h"
 #define MESSAGE_LIMIT 1024
 
 class PubThread
@@ -18,24 +20,54 @@ private:
     * The timneline associated with this thread
     */
     Timeline* timeline;
+    EventManager* manager;
+
     /**
-    * The mutex for mutual exclusion
+    * The server's rooms, stepped every tic on roomPool.
     */
-    std::mutex* mutex;
+    std::vector<Room*>* rooms;
+    RoomPool* roomPool;
 
-    EventManager* manager;
+    /**
+    * The transport the publisher socket is created from.
+    */
+    Transport* transport;
+
+    /**
+    * Set by the server when the thread should stop publishing.
+    */
+    std::atomic<bool>* stopped;
 
-    int* highScore;
+    /**
+    * Messages rebuilt in place for every room, every tic.
+    */
+    zmq::message_t rtnMessage;
+    zmq::message_t boardMessage;
+    zmq::message_t leaderboardMessage;
 
 public:
     /**
     * Constructor
     */
-    PubThread(Timeline* timeline, int *highScore, std::mutex *m, EventManager *manager);
+    PubThread(Transport* transport, Timeline* timeline, std::vector<Room*>* rooms, RoomPool* roomPool, EventManager *manager, std::atomic<bool>* stopped);
 
     /**
-    * run the program. It is responsible for the movement of a platform, which goes back and forth between two bounds.
+    * run the program. Once per tic steps every room, then for each one publishes
+    * "<room> <high score> <microseconds the previous tic's step and publish took>" on PUB_PORT and "<room> " and the arena's
+    * writeState() on BOARD_PORT: what changed, and the whole board every BOARD_FULL_TICS. A room's leaderboard goes
+    * out on LEADERBOARD_PORT, after "<room> ", on tics it changed, and in full every LEADERBOARD_FULL_TICS.
     */
     void run();
+
+    /**
+    * Send what the room wrote in its last step(): the board on boardSocket, the update on pubSocket and the
+    * leaderboard on leaderboardSocket if there was one.
+    */
+    void publish(Room* room, int64_t ticMicros, zmq::socket_t* pubSocket, zmq::socket_t* boardSocket, zmq::socket_t* leaderboardSocket);
+
+    /**
+    * Write one publisher update into message. Short enough to stay inside the message, so this never allocates.
+    */
+    static void buildUpdate(MessagePool* pool, zmq::message_t* message, int room, int highScore, int64_t ticMicros);
 };
 #endif
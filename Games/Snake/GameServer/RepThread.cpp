@@ -1,98 +1,247 @@
 #include "RepThread.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
 
 
 
-RepThread::RepThread(int port, int id, int *highScore, std::mutex *m, Timeline *time, EventManager *manager) {
-    this->port = port;
-    this->id = id;
-    this->highScore = highScore;
-    this->mutex = m;
+RepThread::RepThread(Transport* transport, SessionManager* sessions, std::vector<Room*>* rooms, Timeline *time, EventManager *manager, std::atomic<bool>* stopped) {
+    this->rooms = rooms;
+    this->transport = transport;
+    this->sessions = sessions;
+    this->stopped = stopped;
     this->time = time;
     this->manager = manager;
+
+    gameOver.type = "Client_Closed";
+    Event::variant messageVariant;
+    messageVariant.m_Type = Event::variant::TYPE_STRING;
+    messageVariant.m_asString = "Game Over";
+    gameOver.parameters.insert({ "message", messageVariant });
 }
 
-void RepThread::run() {
-    //Bind ourself to the port.
-    char portString[21];
-    sprintf_s(portString, "%s%d", "tcp://localhost:", port);
+void RepThread::attach(std::shared_ptr<Session> session, int generation) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.push_back({ session, generation });
+}
 
-    zmq::context_t context(2);
-    zmq::socket_t repSocket(context, zmq::socket_type::rep);
-    repSocket.connect(portString);
+void RepThread::packEntities(Connection& connection, zmq::message_t* message, int64_t currentTic) {
+    //Only players in the same room matter.
+    int room = connection.session->room;
+    const EntityState* first = players->entities.data() + players->roomStart[room];
+    const EntityState* last = players->entities.data() + players->roomStart[room + 1];
+
+    //Where this client is, and who is winning.
+    float ownX = 0;
+    float ownY = 0;
+    int leader = -1;
+    for (const EntityState* i = first; i != last; i++) {
+        const EntityState& e = *i;
+        leader = std::max(leader, e.score);
+        if (e.id == connection.session->id) {
+            ownX = e.x;
+            ownY = e.y;
+        }
+    }
 
-    Event init;
-    init.type = "Client_Closed";
-    std::string message = "Game Over";
-    Event::variant messageVariant;
-    messageVariant.m_Type = Event::variant::TYPE_STRING;
-    messageVariant.m_asString = message.data();
-    init.parameters.insert({ "message", messageVariant });
-
-    Event::variant socketVariant;
-    socketVariant.m_Type = Event::variant::TYPE_SOCKET;
-    socketVariant.m_asSocket = &repSocket;
-    init.parameters.insert({ "socket", socketVariant });
-
-    zmq::message_t update;
-    zmq::recv_result_t received(repSocket.recv(update, zmq::recv_flags::none));
-
-    init.time = GAME_LENGTH - manager->getTimeline()->getGlobalTime(); //Time differential
-    std::string rtnString = init.toString();
-
-
-    zmq::message_t reply(rtnString.size() + 1);
-    memcpy(reply.data(), rtnString.data(), rtnString.size() + 1);
-
-    repSocket.send(reply, zmq::send_flags::none);
-
-    int64_t tic = time->getTime();
-    int64_t currentTic = tic;
-    int64_t heartbeatTic = 0;
-    float ticLength;
-    bool connected = true;
-    while (connected) {
-
-        ticLength = time->getRealTicLength();
-        currentTic = time->getTime();
-        while (currentTic > tic) {
-            currentTic = time->getTime();
-            //Receive message from client
-            zmq::message_t update;
-            zmq::recv_result_t received;
-            {
-                std::lock_guard<std::mutex> lock(*mutex);
-                received = repSocket.recv(update, zmq::recv_flags::dontwait);
+    candidates.clear();
+    for (const EntityState* i = first; i != last; i++) {
+        const EntityState& e = *i;
+        if (e.id == connection.session->id) {
+            continue;
+        }
+        EntityPriority& p = connection.priorities[e.id];
+        p.seenTic = currentTic;
+        //Closer players, longer players and the leader matter more. Players that haven't moved still creep up.
+        float distance = std::sqrt((e.x - ownX) * (e.x - ownX) + (e.y - ownY) * (e.y - ownY));
+        float weight = NEAR_DISTANCE / (NEAR_DISTANCE + distance);
+        weight *= 1.f + e.score / 10.f;
+        if (leader > 0 && e.score == leader) {
+            weight *= 2.f;
+        }
+        if (e.changedTic <= p.sentTic) {
+            weight *= STALE_WEIGHT;
+        }
+        p.priority += weight;
+        candidates.push_back({ p.priority, &e });
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const std::pair<float, const EntityState*>& a, const std::pair<float, const EntityState*>& b) { return a.first > b.first; });
+
+    //Fill the packet, most important first, with what this tic's earlier replies left. Leave room for the null.
+    if (connection.budgetTic != currentTic) {
+        connection.budgetTic = currentTic;
+        connection.sentThisTic = 0;
+    }
+    char* buffer = transport->getPool()->acquire();
+    int limit = std::max(0, std::min(connection.budget - connection.sentThisTic, POOL_BUFFER_SIZE - 1));
+    int used = 0;
+    char record[64];
+    for (std::pair<float, const EntityState*>& c : candidates) {
+        const EntityState* e = c.second;
+        int length = snprintf(record, sizeof(record), "%d %.0f %.0f %d,", e->id, e->x, e->y, e->score);
+        if (used + length > limit) {
+            continue;
+        }
+        memcpy(buffer + used, record, length);
+        used += length;
+        EntityPriority& p = connection.priorities[e->id];
+        p.priority = 0;
+        p.sentTic = currentTic;
+    }
+    buffer[used] = '\0';
+    connection.sentThisTic += used;
+    transport->getPool()->wrap(message, buffer, used + 1);
+
+    //Forget players that have left.
+    if (connection.priorities.size() > (size_t)(last - first) + 16) {
+        for (auto it = connection.priorities.begin(); it != connection.priorities.end();) {
+            if (it->second.seenTic != currentTic) {
+                it = connection.priorities.erase(it);
+            }
+            else {
+                it++;
             }
-            if ((received.has_value() && (EAGAIN != received.value()))) {
-                std::string updateString((char*)update.data());
-                int score = stoi(updateString);
+        }
+    }
+}
 
-                //If it is a client that is disconnecting, remove them from the map
-                if (score <= 0) {
-                    connected = false;
-                }
-                if (score > *highScore) {
-                    std::lock_guard<std::mutex> lock(*mutex);
-                    *highScore = score;
-                }
-                //Send a response with the character's new ID
+void RepThread::snapshot(int64_t currentTic) {
+    if (players == nullptr || players->tic != currentTic) {
+        players = sessions->snapshot(currentTic, std::move(players));
+    }
+}
+
+bool RepThread::serve(Connection& connection, int64_t currentTic) {
+    //Receive message from client: the direction it steers in, -1 to keep going, or "Leave".
+    zmq::recv_result_t received(connection.socket.recv(update, zmq::recv_flags::none));
+    const char* request = (const char*)update.data();
+    bool leaving = strncmp(request, "Leave", 5) == 0;
+    char* end;
+    long direction = strtol(request, &end, 10);
+    bool valid = end != request && *end == '\0' && direction >= -1 && direction <= Arena::DOWN;
+    connection.lastTic = currentTic;
+
+    //The first reply tells the client when the game ends.
+    if (!connection.greeted) {
+        gameOver.time = GAME_LENGTH - manager->getTimeline()->getGlobalTime(); //Time differential
+        transport->getPool()->copy(&reply, gameOver.toString());
+        connection.socket.send(reply, zmq::send_flags::none);
+        connection.greeted = true;
+        return true;
+    }
+
+    //A client that is disconnecting. Its session (and snake) is gone for good.
+    if (leaving) {
+        transport->getPool()->format(&reply, "Connected");
+        connection.socket.send(reply, zmq::send_flags::none);
+        {
+            std::lock_guard<std::mutex> lock(*connection.room->getMutex());
+            connection.room->getArena()->removeSnake(connection.session->id);
+        }
+        sessions->remove(connection.session, connection.generation);
+        return false;
+    }
+    //Clients only steer. Anything else (a score or a position of its own) is not for the client to say.
+    if (!valid) {
+        transport->getPool()->format(&reply, "Rejected");
+        connection.socket.send(reply, zmq::send_flags::none);
+        return true;
+    }
+    //Every client plays in its room's arena, and the arena decides its score and where it is.
+    int score;
+    sf::Vector2f head;
+    {
+        std::lock_guard<std::mutex> lock(*connection.room->getMutex());
+        Arena* arena = connection.room->getArena();
+        arena->addSnake(connection.session->id);
+        if (direction >= 0) {
+            arena->steer(connection.session->id, (int)direction);
+        }
+        score = arena->getScore(connection.session->id);
+        head = arena->getHeadPosition(connection.session->id);
+    }
+    connection.room->getLeaderboard()->report(connection.session->id, score);
+    sessions->update(connection.session, score, head.x, head.y, currentTic);
 
-                std::stringstream stream;
-                stream << "Connected";
-                std::string rtnString;
-                std::getline(stream, rtnString);
+    //A client that took more than a couple of tics to come back can't keep up. Send it less.
+    if (currentTic - connection.replyTic > 2) {
+        connection.budget = std::max(MIN_BUDGET, connection.budget / 2);
+    }
+    else {
+        connection.budget = std::min(connection.session->budget, connection.budget + BUDGET_STEP);
+    }
+    connection.replyTic = currentTic;
 
-                zmq::message_t reply(rtnString.size() + 1);
-                memcpy(reply.data(), rtnString.data(), rtnString.size() + 1);
-                repSocket.send(reply, zmq::send_flags::none);
-                tic = currentTic;
+    transport->getPool()->format(&reply, "Connected");
+    connection.socket.send(reply, zmq::send_flags::sndmore);
+    packEntities(connection, &others, currentTic);
+    connection.socket.send(others, zmq::send_flags::none);
+    return true;
+}
+
+void RepThread::run() {
+    std::list<Connection> connections;
+    std::vector<zmq::pollitem_t> items;
+
+    while (!(*stopped)) {
+        int64_t currentTic = time->getTime();
+
+        //Pick up sessions the server handed us.
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            for (std::pair<std::shared_ptr<Session>, int> i : pending) {
+                //A client that reconnected before we dropped it. Throw away the stale socket.
+                connections.remove_if([&](const Connection& c) { return c.session == i.first; });
+                connections.emplace_back();
+                Connection& connection = connections.back();
+                connection.session = i.first;
+                connection.room = (*rooms)[i.first->room];
+                connection.generation = i.second;
+                connection.lastTic = currentTic;
+                connection.replyTic = currentTic;
+                connection.budget = i.first->budget;
+                //Connect to the port the client binds to.
+                connection.socket = zmq::socket_t(*transport->getContext(), zmq::socket_type::rep);
+                connection.socket.set(zmq::sockopt::linger, 0);
+                connection.socket.connect(transport->endpoint(i.first->port));
+            }
+            pending.clear();
+        }
+
+        if (connections.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        //Everyone's state, once a tic.
+        snapshot(currentTic);
+
+        items.clear();
+        for (Connection& connection : connections) {
+            items.push_back({ connection.socket.handle(), 0, ZMQ_POLLIN, 0 });
+        }
+        zmq::poll(items.data(), items.size(), std::chrono::milliseconds(1));
+
+        size_t index = 0;
+        for (auto it = connections.begin(); it != connections.end(); index++) {
+            Connection& connection = *it;
+            if (items[index].revents & ZMQ_POLLIN) {
+                if (!serve(connection, currentTic)) {
+                    it = connections.erase(it);
+                    continue;
+                }
             }
-            //Disconnect client if we haven't heard from them in 100 tics.
-            else if (currentTic - tic >= 100) {
-                std::lock_guard<std::mutex> lock(*mutex);
-                tic = currentTic;
-                connected = false;
+            //Drop the client if we haven't heard from them in a while. It can still resume.
+            else if (currentTic - connection.lastTic >= DROP_TICS) {
+                sessions->detach(connection.session, connection.generation, currentTic);
+                it = connections.erase(it);
+                continue;
             }
+            it++;
         }
     }
 }
@@ -2,30 +2,103 @@
 #define REPTHREAD_H
 #include <zmq.hpp>
 #include <thread>
-#include <map>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <memory>
 #include <mutex>
+#include <atomic>
 #include <iostream> //TODO: Remove
 #include "Timeline.h"
 #include "Character.h"
 #include "EventManager.h"
+#include "Transport.h"
+#include "SessionManager.h"
+#include "Room.h"
 #define GAME_LENGTH 10000000000
 #define MESSAGE_LIMIT 1024
+//Tics of silence before a client is dropped.
+#define DROP_TICS 100
+//A client's budget never shrinks below this many bytes, so it always hears about someone.
+#define MIN_BUDGET 32
+//Bytes the budget grows by for each reply a client keeps up with.
+#define BUDGET_STEP 16
+//Distance (in pixels) at which a player counts half as much as one right next to you.
+#define NEAR_DISTANCE 200.f
+//How much a player that hasn't changed since it was last sent counts, compared to one that has.
+#define STALE_WEIGHT .25f
 
-class RepThread
-{
-private:
+/**
+* How much one client wants to hear about one other player.
+*/
+struct EntityPriority {
+    /**
+    * Grows every reply the player is left out of and goes back to 0 when it is sent.
+    */
+    float priority = 0;
+    /**
+    * Tic the player was last sent on, -1 if never.
+    */
+    int64_t sentTic = -1;
+    /**
+    * Tic the player was last in the snapshot. Used to forget players that are gone.
+    */
+    int64_t seenTic = 0;
+};
+
+/**
+* A session being served by a RepThread.
+*/
+struct Connection {
+    std::shared_ptr<Session> session;
     /**
-    * The port that this thread is/will be binded to.
+    * The room the session is in.
     */
-    int port;
+    Room* room;
     /**
-    * The ID of this thread and the client connecting to it.
+    * The session generation this connection was made for.
     */
-    int id;
+    int generation;
     /**
-    * mutex for mutual exclusion
+    * Reply socket connected to the client's port.
     */
-    std::mutex* mutex;
+    zmq::socket_t socket;
+    /**
+    * False until the client gets its first reply (the game over event).
+    */
+    bool greeted = false;
+    /**
+    * Tic the client was last heard from.
+    */
+    int64_t lastTic;
+    /**
+    * Tic the client last got a reply on.
+    */
+    int64_t replyTic;
+    /**
+    * Bytes of other players this client gets per tic right now. Halves when the client falls behind and
+    * grows back towards session->budget while it keeps up.
+    */
+    int budget;
+    /**
+    * The tic the client last got other players in, and how many bytes of them it got in that tic. A client that
+    * sends several requests in one tic shares one budget between the replies.
+    */
+    int64_t budgetTic = -1;
+    int sentThisTic = 0;
+    /**
+    * Priority accumulator for every other player, by ID.
+    */
+    std::unordered_map<int, EntityPriority> priorities;
+};
+
+/**
+* Serves any number of sessions from one thread. The server keeps a small fixed pool of these and hands every
+* new or resumed session to one of them with attach(), so a handshake never starts a thread.
+*/
+class RepThread
+{
+private:
     /**
     * the timeline associated with this thread
     */
@@ -33,15 +106,94 @@ private:
 
     EventManager* manager;
 
-    int* highScore;
+    /**
+    * The server's rooms, by ID. Every client's arena score goes to its room's leaderboard, where sessions of this
+    * thread all fall in one shard.
+    */
+    std::vector<Room*>* rooms;
+
+    /**
+    * The transport the reply sockets are created from.
+    */
+    Transport* transport;
+
+    /**
+    * The table sessions are detached from and removed from.
+    */
+    SessionManager* sessions;
+
+    /**
+    * Sessions handed over by attach() that run() hasn't picked up yet, with their generation.
+    */
+    std::list<std::pair<std::shared_ptr<Session>, int>> pending;
+
+    /**
+    * Protects pending.
+    */
+    std::mutex pendingMutex;
+
+    /**
+    * Set by the server when every client thread should stop.
+    */
+    std::atomic<bool>* stopped;
+
+    /**
+    * Every attached player, taken once a tic and shared with the other RepThreads.
+    */
+    std::shared_ptr<const Snapshot> players;
+
+    /**
+    * The first reply every client gets, telling it when the game ends.
+    */
+    Event gameOver;
+
+    /**
+    * Request and reply messages, rebuilt in place for every request.
+    */
+    zmq::message_t update;
+    zmq::message_t reply;
+    zmq::message_t others;
+
+    /**
+    * Scratch list for packEntities(), kept so it doesn't allocate every reply.
+    */
+    std::vector<std::pair<float, const EntityState*>> candidates;
+
+    /**
+    * Raise the priority of every other player in the client's room for this client, then write the highest ones
+    * into message as "id x y score," records until what is left of the client's budget for this tic is used up.
+    * The ones sent go back to priority 0. The leader only counts extra once somebody has scored.
+    */
+    void packEntities(Connection& connection, zmq::message_t* message, int64_t currentTic);
 public:
     /**
     * Constructor
     */
-    RepThread(int port, int id, int *highScore, std::mutex *m, Timeline *time, EventManager *manager);
+    RepThread(Transport* transport, SessionManager* sessions, std::vector<Room*>* rooms, Timeline *time, EventManager *manager, std::atomic<bool>* stopped);
+
+    /**
+    * Start serving a session. If this thread is already serving it (the client reconnected before it was dropped)
+    * the old connection is replaced. Safe to call from any thread.
+    */
+    void attach(std::shared_ptr<Session> session, int generation);
+
+    /**
+    * Pick up the snapshot of every player for this tic, which packEntities() works from.
+    */
+    void snapshot(int64_t currentTic);
+
+    /**
+    * Receive one request from the client and reply to it. Returns false if the client left, in which case its
+    * session is removed and the connection should be dropped. Call snapshot() for the tic first.
+    */
+    bool serve(Connection& connection, int64_t currentTic);
 
     /**
-    * run the program. It is responsible for the movement of a platform, which goes back and forth between two bounds.
+    * Serve every attached session until the server stops. Every request is the direction the client steers its
+    * snake in, an Arena::DIRECTION or -1 to keep going. The first one puts a snake in the client's room's arena, and
+    * the client's score and position are taken from there, never from the client. Replies "Connected" with a second
+    * frame of other players packed by packEntities(), or "Rejected" to anything else. "Leave" removes the session,
+    * and sessions that go quiet for DROP_TICS are dropped.
     */
     void run();
 };
@@ -0,0 +1,75 @@
+#include "Room.h"
+#include <algorithm>
+#include <cstring>
+
+Room::Room(int id, Timeline* serverTime, const Level* level, MessagePool* pool, unsigned int seed, WorkerPool* arenaWorkers, int shards)
+    : timeline(serverTime, 1), manager(&timeline), arena(level, seed, arenaWorkers), leaderboard(shards) {
+    this->id = id;
+    this->pool = pool;
+    prefix = std::to_string(id) + " ";
+}
+
+Room::~Room() {
+    if (pooled) {
+        pool->giveBack(board);
+    }
+}
+
+void Room::step(bool fullBoard, bool fullLeaderboard) {
+    manager.handleEvents(timeline.convertGlobal(timeline.getTime()));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        arena.step();
+        if (pooled) {
+            pool->giveBack(board);
+        }
+        size_t size = prefix.size() + arena.stateBound(fullBoard);
+        board = pool->acquire(size);
+        pooled = board != nullptr;
+        if (!pooled) {
+            overflow.resize(std::max(overflow.size(), size));
+            board = overflow.data();
+        }
+        memcpy(board, prefix.data(), prefix.size());
+        boardLength = prefix.size() + arena.writeState(board + prefix.size(), fullBoard);
+    }
+    leadersChanged = leaderboard.publish(fullLeaderboard, &leaderboardState);
+    if (leadersChanged) {
+        leaders.assign(prefix);
+        leaders.append(leaderboardState);
+    }
+}
+
+int Room::getID() {
+    return id;
+}
+
+std::mutex* Room::getMutex() {
+    return &mutex;
+}
+
+Arena* Room::getArena() {
+    return &arena;
+}
+
+Leaderboard* Room::getLeaderboard() {
+    return &leaderboard;
+}
+
+EventManager* Room::getManager() {
+    return &manager;
+}
+
+void Room::takeBoard(zmq::message_t* message) {
+    if (pooled) {
+        pool->wrap(message, board, boardLength + 1);
+        pooled = false;
+    }
+    else {
+        message->rebuild(board, boardLength + 1);
+    }
+}
+
+const std::string* Room::getLeaders() {
+    return leadersChanged ? &leaders : nullptr;
+}
@@ -0,0 +1,126 @@
+#ifndef ROOM_H
+#define ROOM_H
+#include <zmq.hpp>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Timeline.h"
+#include "EventManager.h"
+#include "Arena.h"
+#include "Leaderboard.h"
+#include "Level.h"
+#include "MessagePool.h"
+
+/**
+* One match on a server. Has its own timeline, event queue, arena and leaderboard, so a server can host any number
+* of small matches side by side instead of one per process. Every room plays on the server's Level, which is only
+* read. Players are put in a room at the handshake and only ever see that room.
+* Everything a room publishes starts with "<id> ", so a client subscribes to its own room and nothing else.
+* step() is run by whichever RoomPool thread picks the room up; the RepThreads lock getMutex() around the arena.
+* Rooms have no script context of their own, on purpose. Nothing a room runs is scripted, and v8 only lets the
+* publisher thread into the publisher's isolate, while a room is stepped on any pool thread. Scripting a room would
+* need its own context in that isolate, entered under a v8::Locker.
+*/
+class Room {
+private:
+    /**
+    * Index of the room on the server.
+    */
+    int id;
+
+    /**
+    * Ticks with the server's timeline, and can be paused on its own.
+    */
+    Timeline timeline;
+
+    /**
+    * Events raised on the room. Handled at the start of every step().
+    */
+    EventManager manager;
+
+    /**
+    * Protects arena.
+    */
+    std::mutex mutex;
+
+    Arena arena;
+
+    /**
+    * Every player's best score in this room.
+    */
+    Leaderboard leaderboard;
+
+    /**
+    * "<id> ", what everything the room publishes starts with.
+    */
+    std::string prefix;
+
+    /**
+    * Where the board is written.
+    */
+    MessagePool* pool;
+
+    /**
+    * What the last step() wrote for the publisher: the board, and the leaderboard if it changed. The board is
+    * written straight into a buffer from pool, which takeBoard() hands to zmq, or into overflow if it is too big
+    * for any pooled buffer.
+    */
+    char* board = nullptr;
+    size_t boardLength = 0;
+    bool pooled = false;
+    std::vector<char> overflow;
+    std::string leaders;
+    bool leadersChanged = false;
+
+    /**
+    * Scratch string for Leaderboard::publish().
+    */
+    std::string leaderboardState;
+
+public:
+    /**
+    * Create an empty room.
+    * @param serverTime the server's tic timeline. The room's timeline runs one tic for each of its tics.
+    * @param pool where the board is written every step().
+    * @param arenaWorkers threads to step the arena on. nullptr unless the room has the server to itself.
+    * @param shards leaderboard shards, one per RepThread.
+    */
+    Room(int id, Timeline* serverTime, const Level* level, MessagePool* pool, unsigned int seed, WorkerPool* arenaWorkers, int shards);
+
+    /**
+    * Give back a board that was never sent.
+    */
+    ~Room();
+
+    /**
+    * Handle the room's due events, step the arena and write what the publisher sends for the room this tic.
+    * @param fullBoard true to write the whole board (see Arena::writeState()) instead of what changed.
+    * @param fullLeaderboard true to write the whole leaderboard even if it didn't change.
+    */
+    void step(bool fullBoard, bool fullLeaderboard);
+
+    int getID();
+
+    std::mutex* getMutex();
+
+    /**
+    * Return the arena. Lock getMutex() while using it.
+    */
+    Arena* getArena();
+
+    Leaderboard* getLeaderboard();
+
+    EventManager* getManager();
+
+    /**
+    * Make message send the prefix and the board written by the last step(). A pooled board is handed over without
+    * a copy. Call once per step().
+    */
+    void takeBoard(zmq::message_t* message);
+
+    /**
+    * Return the prefix and the leaderboard update written by the last step(), or nullptr if there was none.
+    */
+    const std::string* getLeaders();
+};
+#endif
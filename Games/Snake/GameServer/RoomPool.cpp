@@ -0,0 +1,16 @@
+#include "RoomPool.h"
+
+RoomPool::RoomPool(WorkerPool* workers) : workers(workers) {
+}
+
+void RoomPool::stepRoom(void* pool, int i) {
+    RoomPool* roomPool = (RoomPool*)pool;
+    (*roomPool->rooms)[i]->step(roomPool->fullBoards, roomPool->fullLeaderboards);
+}
+
+void RoomPool::step(std::vector<Room*>* rooms, bool fullBoards, bool fullLeaderboards) {
+    this->rooms = rooms;
+    this->fullBoards = fullBoards;
+    this->fullLeaderboards = fullLeaderboards;
+    workers->run((int)rooms->size(), stepRoom, this);
+}
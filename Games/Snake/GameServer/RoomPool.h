@@ -0,0 +1,42 @@
+#ifndef ROOMPOOL_H
+#define ROOMPOOL_H
+#include <vector>
+#include "Room.h"
+#include "WorkerPool.h"
+
+/**
+* Steps every room on the server once a tic on the server's WorkerPool, however many rooms there are. The
+* publisher calls step() with all of them, and the pool's threads and the publisher take rooms one at a time until
+* none are left. A room is only ever stepped by one thread at a time, but not always the same one. A single room is
+* stepped on the publisher, which leaves the whole pool to its arena.
+*/
+class RoomPool {
+private:
+    /**
+    * The rooms being stepped and whether their boards and leaderboards go out in full. Set by step() before the
+    * workers are woken.
+    */
+    std::vector<Room*>* rooms = nullptr;
+    bool fullBoards = false;
+    bool fullLeaderboards = false;
+
+    WorkerPool* workers;
+
+    /**
+    * WorkerPool task stepping room i of the pool's rooms.
+    */
+    static void stepRoom(void* pool, int i);
+
+public:
+    /**
+    * Step rooms on the given threads.
+    */
+    RoomPool(WorkerPool* workers);
+
+    /**
+    * Step every room with Room::step(), using the pool's threads and the calling thread, and return when all are
+    * done. Only one thread may call this.
+    */
+    void step(std::vector<Room*>* rooms, bool fullBoards, bool fullLeaderboards);
+};
+#endif
@@ -0,0 +1,109 @@
+#include "Server.h"
+#include <algorithm>
+
+void run_rep(RepThread* fe) {
+    fe->run();
+}
+void run_pub(PubThread* fe) {
+    fe->run();
+}
+
+Server::Server(Transport* transport, Timeline* timeline, EventManager* manager, Level level, int rooms)
+    : level(level), stepWorkers(STEP_WORKERS), roomPool(&stepWorkers), sessions(REP_WORKERS, std::max(1, std::min(rooms, MAX_ROOMS))) {
+    this->transport = transport;
+    this->timeline = timeline;
+    this->manager = manager;
+    stopped = false;
+    rooms = std::max(1, std::min(rooms, MAX_ROOMS));
+    std::random_device seeds;
+    for (int i = 0; i < rooms; i++) {
+        this->rooms.push_back(new Room(i, timeline, &this->level, transport->getPool(), seeds(), rooms == 1 ? &stepWorkers : nullptr, REP_WORKERS));
+    }
+}
+
+Server::~Server() {
+    for (Room* room : rooms) {
+        delete room;
+    }
+}
+
+void Server::stop() {
+    stopped = true;
+}
+
+void Server::run() {
+    //Starting server processes...
+    zmq::socket_t repSocket(*transport->getContext(), zmq::socket_type::rep);
+    repSocket.bind(transport->endpoint(HANDSHAKE_PORT));
+
+    //Create and run publisher thread
+    PubThread pubthread(transport, timeline, &rooms, &roomPool, manager, &stopped);
+    std::thread second(run_pub, &pubthread);
+
+    //Start the threads that serve clients. Handshakes only hand sessions to these.
+    for (int i = 0; i < REP_WORKERS; i++) {
+        workers.push_back(new RepThread(transport, &sessions, &rooms, timeline, manager, &stopped));
+        workerThreads.push_back(new std::thread(run_rep, workers.back()));
+    }
+
+    zmq::message_t request;
+    zmq::message_t reply;
+
+    //Begin main game loop
+    while (!stopped) {
+        //Sessions that were dropped too long ago can't be resumed any more. Their snakes go too.
+        expired.clear();
+        if (sessions.expire(timeline->getTime(), &expired) > 0) {
+            for (std::shared_ptr<Session>& session : expired) {
+                Room* room = rooms[session->room];
+                std::lock_guard<std::mutex> lock(*room->getMutex());
+                room->getArena()->removeSnake(session->id);
+            }
+        }
+
+        //Wait a little while for a new client. Don't block forever so that stop() is noticed.
+        zmq::pollitem_t items[] = { { repSocket.handle(), 0, ZMQ_POLLIN, 0 } };
+        zmq::poll(items, 1, std::chrono::milliseconds(100));
+        if (!(items[0].revents & ZMQ_POLLIN)) {
+            continue;
+        }
+
+        //Check for new clients.
+        zmq::recv_result_t received(repSocket.recv(request, zmq::recv_flags::none));
+
+        //A client coming back with a token gets its old session, unless another connection is still playing it.
+        //Anyone else gets a new one, in the room it asked for if it sent "Join <room>". Any of them may be followed
+        //by the bytes per tic the client wants.
+        std::shared_ptr<Session> session;
+        unsigned long long token = 0;
+        int budget = DEFAULT_BUDGET;
+        int room = -1;
+        if (sscanf_s((char*)request.data(), "Resume %llu %d", &token, &budget) >= 1) {
+            session = sessions.resume(token, timeline->getTime());
+        }
+        else if (sscanf_s((char*)request.data(), "Join %d %d", &room, &budget) < 1) {
+            sscanf_s((char*)request.data(), "Connect %d", &budget);
+        }
+        if (!session) {
+            session = sessions.create(room);
+        }
+        session->budget = std::max(0, std::min(budget, POOL_BUFFER_SIZE - 1));
+        workers[session->worker]->attach(session, session->generation);
+
+        //Return the ID, port, token, the last score we have for the session and its room to the client.
+        transport->getPool()->format(&reply, "%d %d %llu %d %d", session->id, session->port,
+            (unsigned long long)session->token, (int)session->score, session->room);
+        repSocket.send(reply, zmq::send_flags::none);
+        //Done processing new client.
+    }
+
+    //Join with the threads and free their information
+    second.join();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workerThreads[i]->join();
+        delete workerThreads[i];
+        delete workers[i];
+    }
+    workers.clear();
+    workerThreads.clear();
+}
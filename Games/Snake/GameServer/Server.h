@@ -0,0 +1,116 @@
+#ifndef SERVER_H
+#define SERVER_H
+#include <zmq.hpp>
+#include <thread>
+#include <atomic>
+#include <list>
+#include <vector>
+#include <mutex>
+#include "Timeline.h"
+#include "EventManager.h"
+#include "Transport.h"
+#include "RepThread.h"
+#include "PubThread.h"
+#include "SessionManager.h"
+#include "Room.h"
+#include "RoomPool.h"
+#include "Level.h"
+
+//Threads serving client sessions.
+#define REP_WORKERS 4
+//Threads helping the publisher step the rooms, or the regions of the arena when there is one room.
+#define STEP_WORKERS 3
+//Most rooms one server can host.
+#define MAX_ROOMS 4096
+
+/**
+* The server half of the game. Accepts new clients on the handshake port, gives each one a session (ID, personal
+* port, resume token and room), hands it to one of a fixed pool of RepThreads, and runs the publisher that sends
+* each room's high score every tic and its leaderboard on LEADERBOARD_PORT when it changes. A client that sends
+* "Resume <token>" gets its old session back if it hasn't expired, in the same room. "Join <room>" asks for a room,
+* and anyone else is put in the first room that isn't full.
+* Every room is a separate match with its own Arena. Every client steers a snake in its room's arena, which is
+* stepped every tic and published on BOARD_PORT, and follows it there with a BoardView. Clients only ever send their
+* direction: scores and positions come from the arena. The rooms are stepped on one WorkerPool of STEP_WORKERS threads, and a server with one
+* room steps its arena's regions on the same pool instead, for big boards.
+* Does not depend on main(), so the server can be run in its own thread next to clients in the same process.
+*/
+class Server
+{
+private:
+    /**
+    * The transport every server socket is created from.
+    */
+    Transport* transport;
+
+    /**
+    * The timeline the server runs on.
+    */
+    Timeline* timeline;
+
+    /**
+    * The event manager for the server.
+    */
+    EventManager* manager;
+
+    /**
+    * The level every room is played on.
+    */
+    Level level;
+
+    /**
+    * Every room, by ID. Made up front and never changed while the server runs.
+    */
+    std::vector<Room*> rooms;
+
+    /**
+    * The threads the publisher steps the rooms on, or the arena of the only room.
+    */
+    WorkerPool stepWorkers;
+    RoomPool roomPool;
+
+    /**
+    * Scratch list for sessions.expire().
+    */
+    std::vector<std::shared_ptr<Session>> expired;
+
+    /**
+    * Set to true to stop accepting clients and return from run().
+    */
+    std::atomic<bool> stopped;
+
+    /**
+    * Every session, attached or waiting to be resumed.
+    */
+    SessionManager sessions;
+
+    /**
+    * The RepThreads sessions are spread over, and the threads running them.
+    */
+    std::vector<RepThread*> workers;
+    std::vector<std::thread*> workerThreads;
+
+public:
+    /**
+    * Create a server. Nothing is bound until run() is called.
+    * @param level the board every room is played on.
+    * @param rooms the number of rooms, from 1 to MAX_ROOMS.
+    */
+    Server(Transport* transport, Timeline* timeline, EventManager* manager, Level level = Level::makeClassic(), int rooms = 1);
+
+    /**
+    * Free the rooms.
+    */
+    ~Server();
+
+    /**
+    * Bind the handshake port, start the publisher and accept clients until stop() is called.
+    */
+    void run();
+
+    /**
+    * Ask run() to return. Safe to call from any thread.
+    */
+    void stop();
+};
+#endif
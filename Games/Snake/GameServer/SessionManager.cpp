@@ -0,0 +1,154 @@
+#include "SessionManager.h"
+#include <algorithm>
+
+SessionManager::SessionManager(int workers, int rooms) : roomSessions(std::max(1, rooms), 0), random(std::random_device()()) {
+    this->workers = workers;
+}
+
+std::shared_ptr<Session> SessionManager::create(int room) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int rooms = (int)roomSessions.size();
+    if (room < 0 || room >= rooms) {
+        room = (int)(std::min_element(roomSessions.begin(), roomSessions.end()) - roomSessions.begin());
+        for (int i = 0; i < rooms; i++) {
+            if (roomSessions[i] < ROOM_PLAYERS) {
+                room = i;
+                break;
+            }
+        }
+    }
+    std::shared_ptr<Session> session(new Session);
+    session->id = nextId++;
+    if (!freePorts.empty()) {
+        session->port = freePorts.back();
+        freePorts.pop_back();
+    }
+    else {
+        session->port = nextPort++;
+    }
+    //0 means "no token" to clients, and two sessions can't share one.
+    do {
+        session->token = random();
+    } while (session->token == 0 || sessions.count(session->token) != 0);
+    session->worker = session->id % workers;
+    session->room = room;
+    roomSessions[room]++;
+    sessions.insert({ session->token, session });
+    return session;
+}
+
+std::shared_ptr<Session> SessionManager::resume(uint64_t token, int64_t tic) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = sessions.find(token);
+    if (found == sessions.end()) {
+        return nullptr;
+    }
+    Session& session = *found->second;
+    //A connection that went quiet can be taken over by the same client coming back, a live one can't.
+    if (session.attached && tic - session.heardTic <= LIVE_TICS) {
+        return nullptr;
+    }
+    session.attached = true;
+    session.generation++;
+    session.heardTic = tic;
+    return found->second;
+}
+
+void SessionManager::detach(std::shared_ptr<Session> session, int generation, int64_t tic) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (session->generation == generation) {
+        session->attached = false;
+        session->detachedTic = tic;
+    }
+}
+
+void SessionManager::remove(std::shared_ptr<Session> session, int generation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (session->generation == generation && sessions.erase(session->token) != 0) {
+        freePorts.push_back(session->port);
+        roomSessions[session->room]--;
+    }
+}
+
+void SessionManager::update(std::shared_ptr<Session> session, int score, float x, float y, int64_t tic) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (session->score != score || session->x != x || session->y != y) {
+        session->changedTic = tic;
+    }
+    session->score = score;
+    session->x = x;
+    session->y = y;
+    session->heardTic = tic;
+}
+
+std::shared_ptr<const Snapshot> SessionManager::snapshot(int64_t tic, std::shared_ptr<const Snapshot> previous) {
+    std::lock_guard<std::mutex> snapshotLock(snapshotMutex);
+    //Whoever handed it back is done reading it, and the lock orders that before anyone refills it.
+    if (previous != nullptr) {
+        previous->readers--;
+        previous.reset();
+    }
+    if (latest != nullptr && latest->tic == tic) {
+        latest->readers++;
+        return latest;
+    }
+    std::shared_ptr<Snapshot> next;
+    if (spare != nullptr && spare->readers == 0) {
+        next = spare;
+    }
+    else {
+        next = std::make_shared<Snapshot>();
+    }
+
+    int rooms = (int)roomSessions.size();
+    next->roomStart.assign(rooms + 1, 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        //Count every room's players, then put each one straight into its room's range. No sort needed.
+        for (auto& [token, session] : sessions) {
+            if (session->attached) {
+                next->roomStart[session->room + 1]++;
+            }
+        }
+        for (int r = 1; r <= rooms; r++) {
+            next->roomStart[r] += next->roomStart[r - 1];
+        }
+        next->entities.resize(next->roomStart[rooms]);
+        roomFill.assign(next->roomStart.begin(), next->roomStart.end() - 1);
+        for (auto& [token, session] : sessions) {
+            if (session->attached) {
+                next->entities[roomFill[session->room]++] = { session->id, session->room, session->x, session->y, session->score, session->changedTic };
+            }
+        }
+    }
+    next->tic = tic;
+    next->readers = 1;
+    spare = latest;
+    latest = next;
+    return latest;
+}
+
+int SessionManager::expire(int64_t tic, std::vector<std::shared_ptr<Session>>* expired) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int removed = 0;
+    for (auto it = sessions.begin(); it != sessions.end();) {
+        if (!it->second->attached && tic - it->second->detachedTic > RESUME_TICS) {
+            freePorts.push_back(it->second->port);
+            roomSessions[it->second->room]--;
+            if (expired != nullptr) {
+                expired->push_back(it->second);
+            }
+            it = sessions.erase(it);
+            removed++;
+        }
+        else {
+            it++;
+        }
+    }
+    return removed;
+}
+
+int SessionManager::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)sessions.size();
+}
@@ -0,0 +1,197 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "Transport.h"
+
+//How long a dropped session can be resumed, in server tics.
+#define RESUME_TICS 400
+//A session heard from within this many tics still has a live connection, and can't be resumed by another one.
+#define LIVE_TICS 4
+//Bytes of other players' state a client gets per tic unless it asks for something else.
+#define DEFAULT_BUDGET 256
+//Sessions a room takes before players who didn't ask for a room go to the next one.
+#define ROOM_PLAYERS 16
+
+/**
+* One player as the server sees it. Outlives the connection, so a client that drops can come back to it.
+*/
+struct Session {
+    /**
+    * Player ID, kept across reconnects.
+    */
+    int id;
+    /**
+    * Personal port, kept across reconnects.
+    */
+    int port;
+    /**
+    * Secret the client sends back to resume this session.
+    */
+    uint64_t token;
+    /**
+    * Index of the RepThread that serves this session.
+    */
+    int worker;
+    /**
+    * Index of the room the player is in, kept across reconnects.
+    */
+    int room = 0;
+    /**
+    * Bumped every time the session is (re)attached, so a stale connection can't detach a fresh one.
+    */
+    int generation = 0;
+    /**
+    * Last score the session had in its room's arena.
+    */
+    std::atomic<int> score = 0;
+    /**
+    * Last head position the client reported. Protected by the SessionManager.
+    */
+    float x = 0;
+    float y = 0;
+    /**
+    * Tic the score or position last changed on. Protected by the SessionManager.
+    */
+    int64_t changedTic = 0;
+    /**
+    * Bytes per tic the client asked for.
+    */
+    int budget = DEFAULT_BUDGET;
+    /**
+    * True while a RepThread is serving the session.
+    */
+    bool attached = true;
+    /**
+    * Tic the session was detached on.
+    */
+    int64_t detachedTic = 0;
+    /**
+    * Tic the client was last heard from, or the session was resumed on. Protected by the SessionManager.
+    */
+    int64_t heardTic = 0;
+};
+
+/**
+* What other clients are told about a player.
+*/
+struct EntityState {
+    int id;
+    int room;
+    float x;
+    float y;
+    int score;
+    int64_t changedTic;
+};
+
+/**
+* Every attached player at one tic, grouped by room. The players of room r are entities[roomStart[r]] up to
+* entities[roomStart[r + 1]].
+*/
+struct Snapshot {
+    int64_t tic = -1;
+    std::vector<EntityState> entities;
+    std::vector<int> roomStart;
+    /**
+    * RepThreads that took the snapshot and haven't handed it back yet. Protected by the SessionManager's
+    * snapshotMutex.
+    */
+    mutable int readers = 0;
+};
+
+/**
+* The table of every session on the server. Hands out IDs, ports and tokens, and keeps dropped sessions
+* around for RESUME_TICS so their clients can resume instead of joining from scratch. Every session is in one of
+* the server's rooms from the start, and counts towards it until it is removed or expires.
+* Ports of sessions that are gone are handed out again. Safe to use from any thread.
+*/
+class SessionManager {
+private:
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Session>> sessions;
+    std::vector<int> freePorts;
+    int nextId = 0;
+    int nextPort = FIRST_CLIENT_PORT;
+    int workers;
+    /**
+    * Sessions in each room.
+    */
+    std::vector<int> roomSessions;
+    std::mt19937_64 random;
+
+    /**
+    * The snapshot of the latest tic, shared by every RepThread, and the one before it. Every RepThread hands its
+    * snapshot back when it takes the next one, so the one before is refilled for the next tic once it has no
+    * readers left, and a new one is made if it still has some. Protected by snapshotMutex, which is taken before
+    * mutex.
+    */
+    std::shared_ptr<Snapshot> latest;
+    std::shared_ptr<Snapshot> spare;
+    std::mutex snapshotMutex;
+
+    /**
+    * Where the next player of each room goes while a snapshot is filled. Protected by snapshotMutex.
+    */
+    std::vector<int> roomFill;
+
+public:
+    /**
+    * Create an empty table. New sessions are spread over the given number of RepThreads, and put in one of the
+    * given number of rooms.
+    */
+    SessionManager(int workers, int rooms = 1);
+
+    /**
+    * Create a new attached session with a fresh ID, port and token.
+    * @param room the room to put it in. Any other value (like -1) picks the first room with fewer than
+    * ROOM_PLAYERS sessions, or the emptiest if they are all full, so rooms fill up one at a time.
+    */
+    std::shared_ptr<Session> create(int room = -1);
+
+    /**
+    * Reattach the session with this token. A session still attached to a connection that was heard from in the
+    * last LIVE_TICS isn't handed to a second one: the client with the token is already playing it.
+    * @return the session, or nullptr if the token is unknown, has expired or is in use.
+    */
+    std::shared_ptr<Session> resume(uint64_t token, int64_t tic);
+
+    /**
+    * Mark a session as dropped, unless it has been reattached since generation.
+    */
+    void detach(std::shared_ptr<Session> session, int generation, int64_t tic);
+
+    /**
+    * Forget a session that left, unless it has been reattached since generation. Its port is reused.
+    */
+    void remove(std::shared_ptr<Session> session, int generation);
+
+    /**
+    * Record what a client reported this tic.
+    */
+    void update(std::shared_ptr<Session> session, int score, float x, float y, int64_t tic);
+
+    /**
+    * Return the state of every attached session at tic. The first call for a tic takes the snapshot, and every
+    * other call for the same tic shares it, so the table is copied once a tic however many RepThreads ask.
+    * @param previous the snapshot the caller had until now, or nullptr. The caller may not read it again.
+    */
+    std::shared_ptr<const Snapshot> snapshot(int64_t tic, std::shared_ptr<const Snapshot> previous);
+
+    /**
+    * Forget every session that has been detached for more than RESUME_TICS.
+    * @param expired if not null, the sessions removed are added to it.
+    * @return the number of sessions removed.
+    */
+    int expire(int64_t tic, std::vector<std::shared_ptr<Session>>* expired = nullptr);
+
+    /**
+    * Return the number of sessions, attached or not.
+    */
+    int size();
+};
+#endif
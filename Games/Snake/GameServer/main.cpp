@@ -1,13 +1,14 @@
 #include <zmq.hpp>
 #include <string>
+#include <cstring>
+#include <cstdlib>
 #include <iostream>
 #include <list>
 
 #include "MovingPlatform.h"
 #include "Character.h"
 #include "Platform.h"
-#include "RepThread.h"
-#include "PubThread.h"
+#include "Server.h"
 #include "EventManager.h"
 #include "Handlers.h"
 
@@ -42,26 +43,7 @@
 
 #define MESSAGE_LIMIT 1024 //Limit on string length for network messages
 
-void run_rep(RepThread* fe) {
-    fe->run();
-}
-void run_pub(PubThread* fe) {
-    fe->run();
-}
-
-struct ClientStruct {
-    std::thread* thread;
-    RepThread* repThread;
-};
-
-int main() {
-    //This is here to avoid rendering texture issues. Apparently OpenGL will not make a handle unless you make a window and set it active first.
-    //So if you try to load textures in a certain order it fails.
-    //I figured it out by reading this github post: https://github.com/Furthen64/hurkalumo/issues/24
-    //I thought about putting actual OpenGL code here, but it might not work on other platforms, so this'll have to do.
-    sf::RenderWindow window;
-    window.setActive();
-
+int main(int argc, char** argv) {
     //Create MovingPlatform and add it to the window
     MovingPlatform moving(PLAT_SPEED, 1, 150.f, 500.f);
     moving.setSize(sf::Vector2f(100.f, 15.f));
@@ -104,76 +86,17 @@ int main() {
     e.parameters.insert({ "message", messageVariant });
     manager.raise(e);
 
-    //Set up time variables
-    int64_t tic = 0;
-    int64_t currentTic = 0;
-    double scale = 1.0;
-    double ticLength;
-
-    //Set up thread variables
-    bool stopped = false;
-    std::mutex mutex;
-    std::condition_variable cv;
-    bool upPressed = false; //Should be named "canJump"
-
-    //Starting server processes...
-    zmq::context_t context(2);
-    zmq::socket_t repSocket(context, zmq::socket_type::rep);
-    repSocket.bind("tcp://localhost:5556");
-
-    //Creating server information structures...
-    std::map<int, std::shared_ptr<GameObject>> characters;
-    std::list<ClientStruct> clientThreads;
-    int numClients = 0;
-    int numCharacters = 0;
-    int availPort = 5557;
-    int highScore = 1;
-
-    //Create and run publisher thread
-    PubThread pubthread(&FrameTime, &highScore, &mutex, &manager);
-    std::thread second(run_pub, &pubthread);
-
-
-    //Begin main game loop
-    while (true) {
-
-        //Check to see if a new tic has gone by
-        ticLength = FrameTime.getRealTicLength();
-        currentTic = FrameTime.getTime();
-        //It has, do stuff
-        if (currentTic > tic) {
-            //Check for new clients.
-            zmq::message_t request;
-            zmq::recv_result_t received(repSocket.recv(request, zmq::recv_flags::none));
-            
-            //Client received, set up ID and port
-            int newPort = availPort++;
-            int id = numClients++;
-
-            //Create client struct and thread
-            ClientStruct newClient;
-            newClient.repThread = new RepThread(newPort, id, &highScore, &mutex, &FrameTime, &manager);
-            newClient.thread = new std::thread(run_rep, newClient.repThread);
-            clientThreads.push_back(newClient);
-
-            //Return the ID and port to the client.
-            std::stringstream stream;
-            stream << id << ' ' << newPort;
-            std::string rtnString;
-            std::getline(stream, rtnString);
-
-            zmq::message_t reply(rtnString.size() + 1);
-            memcpy(reply.data(), rtnString.data(), rtnString.size() + 1);
-            repSocket.send(reply, zmq::send_flags::none);
-            //Done processing new client.
+    //Start the server. Pass -inproc to use in-process sockets (only useful for clients in this process), and
+    //-rooms N to host N matches side by side.
+    int rooms = 1;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "-rooms") == 0) {
+            rooms = atoi(argv[i + 1]);
         }
     }
+    Transport transport(Transport::parseMode(argc, argv));
+    Server server(&transport, &FrameTime, &manager, Level::makeClassic(), rooms);
+    server.run();
 
-    //Join with the threads and free their information
-    for (ClientStruct i : clientThreads) {
-        i.thread->join();
-        delete i.repThread;
-        delete i.thread;
-    }
     return EXIT_SUCCESS;
 }
\ No newline at end of file
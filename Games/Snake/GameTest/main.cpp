@@ -0,0 +1,324 @@
+#include <zmq.hpp>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "Timeline.h"
+#include "EventManager.h"
+#include "Transport.h"
+#include "Level.h"
+#include "BoardView.h"
+#include "Leaderboard.h"
+#include "Room.h"
+#include "SessionManager.h"
+#include "RepThread.h"
+#include "PubThread.h"
+
+#define TIC 75
+//Clients the reply path serves each round.
+#define CLIENTS 24
+//Rounds run before counting starts, so every pool, map and vector has grown to size, and rounds counted.
+#define WARMUP_ROUNDS 200
+#define ROUNDS 1000
+//Every this many clients turns its snake each round. The rest keep going until they are told to turn.
+#define STEER_EVERY 2
+//Snakes on the board the late view follows, tics it runs for, and the tic it starts following, partway between two
+//full boards.
+#define BOARD_SNAKES 24
+#define BOARD_ROUNDS 400
+#define LATE_JOIN (BOARD_FULL_TICS * 3 + BOARD_FULL_TICS / 2 + 3)
+
+/**
+* Set on the thread whose allocations are being counted. Every other thread is ignored.
+*/
+static thread_local bool counting = false;
+static int64_t allocations = 0;
+
+/**
+* The program's operator new and delete, so every allocation made by the game's code and the standard library is
+* counted in any build. The nothrow and array forms all end up here.
+*/
+void* operator new(size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    void* block = malloc(size == 0 ? 1 : size);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    free(block);
+}
+
+void operator delete(void* block, size_t size) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block, size_t size) noexcept {
+    free(block);
+}
+
+/**
+* Allocations and pooled messages counted on one path.
+*/
+struct PathCount {
+    int64_t allocations = 0;
+    int64_t wrapped = 0;
+};
+
+/**
+* Receive and throw away every message waiting on socket.
+*/
+void drain(zmq::socket_t* socket, zmq::message_t* message) {
+    while (socket->recv(*message, zmq::recv_flags::dontwait)) {
+    }
+}
+
+/**
+* Return true if view has every snake and apple of arena, cell for cell, and nothing else.
+*/
+bool sameBoard(BoardView* view, Arena* arena) {
+    std::vector<ArenaSnake>* snakes = arena->getSnakes();
+    if (view->getSnakes()->size() != snakes->size()) {
+        return false;
+    }
+    for (ArenaSnake& snake : *snakes) {
+        const BoardSnake* seen = view->getSnake(snake.id);
+        if (seen == nullptr || seen->head != snake.head || seen->body.size() != snake.body.size()) {
+            return false;
+        }
+        for (int i = 0; i < snake.body.size(); i++) {
+            if (seen->body.at(i) != snake.body.at(i)) {
+                return false;
+            }
+        }
+    }
+    const OccupancyGrid* board = view->getBoard();
+    for (int cell = 0; cell < board->getColumns() * board->getRows(); cell++) {
+        if (board->contentAt(cell) != arena->getBoard()->contentAt(cell)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+* Check what the server's sends cost. Drives a real RepThread through serve() for CLIENTS clients and a real
+* PubThread through publish() for a room with a board and a leaderboard, over inproc, and counts every operator new
+* made on the sending side. Every client steers a snake in the room's arena.
+*
+* Messages short enough for zmq's inline storage must not allocate at all. Longer ones go out in a pooled buffer,
+* and zmq_msg_init_data allocates its reference count for each of those, so a pooled message may allocate once
+* and no more. That one is made inside libzmq, which this doesn't see, so in practice the game's side has to come
+* to 0. The pool itself must not allocate once it is warm.
+* @return true if every check holds.
+*/
+static bool testSends() {
+    Transport transport(Transport::INPROC);
+    Timeline globalTime;
+    Timeline serverTime(&globalTime, TIC);
+    EventManager manager(&globalTime);
+    Level level = Level::makeClassic();
+    std::vector<Room*> rooms;
+    rooms.push_back(new Room(0, &serverTime, &level, transport.getPool(), 1, nullptr, 1));
+    SessionManager sessions(1, 1);
+    std::atomic<bool> stopped;
+    stopped = false;
+    RepThread rep(&transport, &sessions, &rooms, &serverTime, &manager, &stopped);
+    PubThread pub(&transport, &serverTime, &rooms, nullptr, &manager, &stopped);
+
+    //Subscribers for everything the publisher sends, so the messages really go out.
+    zmq::socket_t pubSocket(*transport.getContext(), zmq::socket_type::pub);
+    pubSocket.bind(transport.endpoint(PUB_PORT));
+    zmq::socket_t boardSocket(*transport.getContext(), zmq::socket_type::pub);
+    boardSocket.bind(transport.endpoint(BOARD_PORT));
+    zmq::socket_t leaderboardSocket(*transport.getContext(), zmq::socket_type::pub);
+    leaderboardSocket.bind(transport.endpoint(LEADERBOARD_PORT));
+    std::vector<zmq::socket_t> subscribers;
+    for (int port : { PUB_PORT, BOARD_PORT, LEADERBOARD_PORT }) {
+        subscribers.emplace_back(*transport.getContext(), zmq::socket_type::sub);
+        subscribers.back().set(zmq::sockopt::subscribe, "");
+        subscribers.back().connect(transport.endpoint(port));
+    }
+
+    //Each client binds its personal port and the RepThread's connection connects to it, as after a handshake.
+    std::vector<zmq::socket_t> clients;
+    std::list<Connection> connections;
+    for (int i = 0; i < CLIENTS; i++) {
+        std::shared_ptr<Session> session = sessions.create(0);
+        clients.emplace_back(*transport.getContext(), zmq::socket_type::req);
+        clients.back().bind(transport.endpoint(session->port));
+        connections.emplace_back();
+        Connection& connection = connections.back();
+        connection.session = session;
+        connection.room = rooms[0];
+        connection.generation = session->generation;
+        connection.lastTic = 0;
+        connection.replyTic = 0;
+        connection.budget = session->budget;
+        connection.socket = zmq::socket_t(*transport.getContext(), zmq::socket_type::rep);
+        connection.socket.set(zmq::sockopt::linger, 0);
+        connection.socket.connect(transport.endpoint(session->port));
+    }
+
+    PathCount replies;
+    PathCount publishing;
+    int64_t poolAllocations = 0;
+    zmq::message_t request;
+    zmq::message_t received;
+    for (int round = 0; round < WARMUP_ROUNDS + ROUNDS; round++) {
+        bool measuring = round >= WARMUP_ROUNDS;
+        if (round == WARMUP_ROUNDS) {
+            poolAllocations = transport.getPool()->getAllocations();
+        }
+        int64_t tic = round;
+        rooms[0]->step(tic % BOARD_FULL_TICS == 0, tic % LEADERBOARD_FULL_TICS == 0);
+
+        //Every client steers its snake in the arena, which turns now and then, dies and spawns again, so the
+        //leaderboard and everyone's priorities change.
+        for (int i = 0; i < CLIENTS; i++) {
+            int direction = i % STEER_EVERY == 0 || round % 7 == 0 ? (i + round / 5) % 4 : -1;
+            transport.getPool()->format(&request, "%d", direction);
+            clients[i].send(request, zmq::send_flags::none);
+        }
+        counting = measuring;
+        int64_t before = allocations;
+        int64_t wrappedBefore = transport.getPool()->getWrapped();
+        rep.snapshot(tic);
+        for (Connection& connection : connections) {
+            rep.serve(connection, tic);
+        }
+        counting = false;
+        if (measuring) {
+            replies.allocations += allocations - before;
+            replies.wrapped += transport.getPool()->getWrapped() - wrappedBefore;
+        }
+        for (zmq::socket_t& client : clients) {
+            do {
+                client.recv(received, zmq::recv_flags::none);
+            } while (received.more());
+        }
+
+        counting = measuring;
+        before = allocations;
+        wrappedBefore = transport.getPool()->getWrapped();
+        pub.publish(rooms[0], TIC * 1000, &pubSocket, &boardSocket, &leaderboardSocket);
+        counting = false;
+        if (measuring) {
+            publishing.allocations += allocations - before;
+            publishing.wrapped += transport.getPool()->getWrapped() - wrappedBefore;
+        }
+        for (zmq::socket_t& subscriber : subscribers) {
+            drain(&subscriber, &received);
+        }
+    }
+    poolAllocations = transport.getPool()->getAllocations() - poolAllocations;
+
+    bool passed = true;
+    char line[256];
+    snprintf(line, sizeof(line), "replies: %lld allocations, %lld pooled messages over %d requests",
+        (long long)replies.allocations, (long long)replies.wrapped, ROUNDS * CLIENTS);
+    std::cout << line << std::endl;
+    passed = passed && replies.allocations <= replies.wrapped;
+    snprintf(line, sizeof(line), "publish: %lld allocations, %lld pooled messages over %d tics",
+        (long long)publishing.allocations, (long long)publishing.wrapped, ROUNDS);
+    std::cout << line << std::endl;
+    passed = passed && publishing.allocations <= publishing.wrapped;
+    snprintf(line, sizeof(line), "pool: %lld new buffers after warm up", (long long)poolAllocations);
+    std::cout << line << std::endl;
+    passed = passed && poolAllocations == 0;
+
+    connections.clear();
+    clients.clear();
+    subscribers.clear();
+    delete rooms[0];
+    return passed;
+}
+
+/**
+* Check that a client can follow a room's board. BOARD_SNAKES snakes play in a room's arena, which a real PubThread
+* publishes on BOARD_PORT over inproc, and a BoardView that starts following the board late, between two full boards,
+* has to end up with the same snakes, bodies and apples as the arena.
+* @return true if it does.
+*/
+static bool testLateBoard() {
+    Transport transport(Transport::INPROC);
+    Timeline globalTime;
+    Timeline serverTime(&globalTime, TIC);
+    EventManager manager(&globalTime);
+    Level level = Level::makeClassic();
+    std::vector<Room*> rooms;
+    rooms.push_back(new Room(0, &serverTime, &level, transport.getPool(), 1, nullptr, 1));
+    std::atomic<bool> stopped;
+    stopped = false;
+    PubThread pub(&transport, &serverTime, &rooms, nullptr, &manager, &stopped);
+
+    zmq::socket_t pubSocket(*transport.getContext(), zmq::socket_type::pub);
+    pubSocket.bind(transport.endpoint(PUB_PORT));
+    zmq::socket_t boardSocket(*transport.getContext(), zmq::socket_type::pub);
+    boardSocket.bind(transport.endpoint(BOARD_PORT));
+    zmq::socket_t leaderboardSocket(*transport.getContext(), zmq::socket_type::pub);
+    leaderboardSocket.bind(transport.endpoint(LEADERBOARD_PORT));
+    zmq::socket_t subscriber(*transport.getContext(), zmq::socket_type::sub);
+    subscriber.set(zmq::sockopt::subscribe, "");
+    subscriber.connect(transport.endpoint(BOARD_PORT));
+
+    Arena* arena = rooms[0]->getArena();
+    for (int i = 0; i < BOARD_SNAKES; i++) {
+        arena->addSnake(i);
+    }
+    BoardView view(&level);
+    zmq::message_t received;
+    for (int round = 0; round < BOARD_ROUNDS; round++) {
+        int64_t tic = round;
+        //Snakes turn now and then, die and spawn again, so bodies come and go between full boards.
+        for (int i = 0; i < BOARD_SNAKES; i++) {
+            if (i % STEER_EVERY == 0 || round % 7 == 0) {
+                arena->steer(i, (i + round / 5) % 4);
+            }
+        }
+        rooms[0]->step(tic % BOARD_FULL_TICS == 0, tic % LEADERBOARD_FULL_TICS == 0);
+        pub.publish(rooms[0], TIC * 1000, &pubSocket, &boardSocket, &leaderboardSocket);
+        while (subscriber.recv(received, zmq::recv_flags::dontwait)) {
+            if (round >= LATE_JOIN) {
+                view.apply(strchr((char*)received.data(), ' ') + 1);
+            }
+        }
+    }
+
+    bool passed = view.isSynced() && sameBoard(&view, arena);
+    char line[256];
+    snprintf(line, sizeof(line), "board: %d snakes, view joined late is %s the arena", arena->size(),
+        passed ? "the same as" : "different from");
+    std::cout << line << std::endl;
+
+    delete rooms[0];
+    return passed;
+}
+
+/**
+* Run every test. Exits 0 if they all pass, 1 if one doesn't.
+*/
+int main(int argc, char** argv) {
+    bool passed = testSends();
+    passed = testLateBoard() && passed;
+    std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+    return passed ? 0 : 1;
+}